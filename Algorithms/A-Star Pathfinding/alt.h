@@ -0,0 +1,199 @@
+// The ALT heuristic (A*, Landmarks and the Triangle inequality; Goldberg and Harrelson, 2005).
+// A few landmark cells are picked once per map, and the length of the shortest path from each of
+// them to every cell is saved to a file. For any landmark L, the triangle inequality gives
+// d(v, t) >= |d(L, t) - d(L, v)|, so the largest of these bounds over all landmarks is an
+// admissible and consistent h_cost. Behind walls it is usually far closer to the real distance
+// than the octile distance, which only knows about the geometry of the grid.
+//
+// Landmarks are picked by farthest-point selection: the first is the cell farthest from the map's
+// start, and each next one is the cell farthest from every landmark picked so far, so they end up
+// spread around the edges of the map where their bounds are tightest.
+//
+// The file is a LandmarkHeader, the cell index of each landmark, and then the distances: the
+// distance from every landmark to cell 0, then to cell 1, and so on, so that the bounds of a
+// cell are read from one or two cache lines. It is mapped into memory as is when loaded, so
+// loading takes no time regardless of its size and several processes can share it.
+
+// Distances are saved in the order of cell indices, so tiled builds (see map.h) have files of
+// their own.
+#if LAYOUT == LAYOUT_TILED
+    #define LANDMARK_MAGIC "ALT8"
+#else
+    #define LANDMARK_MAGIC "ALT1"
+#endif
+#define LANDMARK_UNREACHED UINT32_MAX // The distance to a cell a landmark can't reach.
+
+typedef struct {
+    char magic[4];
+    int32_t num_rows;
+    int32_t num_cols;
+    int32_t num_landmarks;
+} LandmarkHeader;
+
+// Function declarations --------------------------------------------------------------------------
+
+int make_landmarks(Grid* grid, int num_landmarks, char* file_name);
+void flood_search(Search* search, uint32_t index);
+int load_landmarks(Landmarks* landmarks, Grid* grid, char* file_name);
+int get_landmark_bound(Landmarks* landmarks, uint32_t index1, uint32_t index2);
+void free_landmarks(Landmarks* landmarks);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int make_landmarks(Grid* grid, int num_landmarks, char* file_name) {
+    /* Picks up to num_landmarks landmarks on the grid, finds the distance from each of them to
+    every cell and saves it all to file_name. Fewer landmarks are picked if the start's part of
+    the map runs out of cells. Returns the number of landmarks saved, or -1 on failure. */
+
+    size_t num_cells = grid->num_cells;
+    if (num_landmarks <= 0 || grid->start_index == NO_INDEX ||
+        is_obstacle(grid, grid->start_index)) {
+        return -1;
+    }
+
+    Search search;
+    init_search(&search, grid, NULL, BUCKET_QUEUE);
+
+    uint32_t* distances = malloc(num_cells * num_landmarks * sizeof *(distances));
+    uint32_t* landmark_index = malloc(num_landmarks * sizeof *(landmark_index));
+
+    // The distance from each cell to its closest landmark so far. Cells the start can't reach
+    // stay at 0 so they're never picked.
+    uint32_t* min_distance = malloc(num_cells * sizeof *(min_distance));
+    uint32_t next_index = grid->start_index, farthest = 0;
+    flood_search(&search, grid->start_index);
+    for (size_t i = 0; i < num_cells; i++) {
+        min_distance[i] = is_reached(&search, i) ? LANDMARK_UNREACHED : 0;
+        if (is_reached(&search, i) && (uint32_t) search.nodes[i].g_cost > farthest) {
+            farthest = search.nodes[i].g_cost;
+            next_index = i;
+        }
+    }
+
+    int found = 0;
+    while (found < num_landmarks) {
+        landmark_index[found] = next_index;
+        flood_search(&search, next_index);
+
+        farthest = 0;
+        for (size_t i = 0; i < num_cells; i++) {
+            uint32_t distance = is_reached(&search, i) ? (uint32_t) search.nodes[i].g_cost
+                                                       : LANDMARK_UNREACHED;
+            distances[i * num_landmarks + found] = distance;
+            if (distance < min_distance[i]) {
+                min_distance[i] = distance;
+            }
+            if (min_distance[i] > farthest) {
+                farthest = min_distance[i];
+                next_index = i;
+            }
+        }
+        found++;
+
+        // Every cell is a landmark already.
+        if (farthest == 0) {
+            break;
+        }
+    }
+
+    // Close the gaps left by landmarks that weren't picked.
+    if (found < num_landmarks) {
+        for (size_t i = 0; i < num_cells; i++) {
+            memmove(&distances[i * found], &distances[i * num_landmarks],
+                found * sizeof *(distances));
+        }
+    }
+
+    LandmarkHeader header;
+    memcpy(header.magic, LANDMARK_MAGIC, sizeof header.magic);
+    header.num_rows = grid->num_rows;
+    header.num_cols = grid->num_cols;
+    header.num_landmarks = found;
+
+    FILE* fp = fopen(file_name, "wb");
+    int saved = (fp != NULL &&
+        fwrite(&header, sizeof header, 1, fp) == 1 &&
+        fwrite(landmark_index, sizeof *(landmark_index), found, fp) == (size_t) found &&
+        fwrite(distances, sizeof *(distances) * found, num_cells, fp) == num_cells);
+    if (fp != NULL && fclose(fp) != 0) {
+        saved = 0;
+    }
+
+    free(min_distance);
+    free(landmark_index);
+    free(distances);
+    free_search(&search);
+    return saved ? found : -1;
+}
+
+void flood_search(Search* search, uint32_t index) {
+    /* Runs Dijkstra's algorithm from a cell until every cell it can reach has been expanded, so
+    the g_cost of each reached node is its distance from the cell. */
+    reset_search(search, index, NO_INDEX);
+    find_path(search);
+}
+
+int load_landmarks(Landmarks* landmarks, Grid* grid, char* file_name) {
+    /* Maps a landmark file made by make_landmarks into memory. Returns 0, or -1 if the file
+    can't be read or wasn't made for a grid of this size. */
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || (size_t) file_stat.st_size < sizeof(LandmarkHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    landmarks->file_size = file_stat.st_size;
+    landmarks->file = mmap(NULL, landmarks->file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (landmarks->file == MAP_FAILED) {
+        return -1;
+    }
+
+    LandmarkHeader* header = landmarks->file;
+    size_t num_cells = grid->num_cells;
+    size_t num_landmarks = (header->num_landmarks > 0) ? header->num_landmarks : 0;
+    if (memcmp(header->magic, LANDMARK_MAGIC, sizeof header->magic) != 0 ||
+        header->num_rows != grid->num_rows || header->num_cols != grid->num_cols ||
+        num_landmarks == 0 || landmarks->file_size != sizeof *(header) +
+        num_landmarks * sizeof(uint32_t) + num_cells * num_landmarks * sizeof(uint32_t)) {
+        munmap(landmarks->file, landmarks->file_size);
+        return -1;
+    }
+
+    landmarks->num_landmarks = num_landmarks;
+    landmarks->landmark_index = (uint32_t*) (header + 1);
+    landmarks->distances = landmarks->landmark_index + num_landmarks;
+    return 0;
+}
+
+int get_landmark_bound(Landmarks* landmarks, uint32_t index1, uint32_t index2) {
+    /* Returns the largest lower bound the landmarks give on the distance between two cells.
+    Landmarks that can't reach both cells don't give a bound. */
+
+    int num_landmarks = landmarks->num_landmarks;
+    uint32_t* distances1 = &landmarks->distances[(size_t) index1 * num_landmarks];
+    uint32_t* distances2 = &landmarks->distances[(size_t) index2 * num_landmarks];
+
+    int bound = 0;
+    for (int i = 0; i < num_landmarks; i++) {
+        if (distances1[i] == LANDMARK_UNREACHED || distances2[i] == LANDMARK_UNREACHED) {
+            continue;
+        }
+        int difference = abs((int) distances1[i] - (int) distances2[i]);
+        if (difference > bound) {
+            bound = difference;
+        }
+    }
+
+    return bound;
+}
+
+void free_landmarks(Landmarks* landmarks) {
+    munmap(landmarks->file, landmarks->file_size);
+}
@@ -0,0 +1,303 @@
+// Anytime repairing A* (ARA*; Likhachev, Gordon and Thrun, 2003), for when a path is needed within
+// a time budget and a shorter one is only worth having if there is time left to find it.
+//
+// The first round is a weighted A*: every node's f_cost is its g_cost plus its h_cost inflated by
+// epsilon > 1, which heads for the end much more greedily and finds a path costing at most epsilon
+// times the shortest one. Each later round lowers epsilon by a step and improves the path, until
+// the path is proven to be the shortest or the budget runs out, when the best path so far is kept.
+//
+// Rounds reuse each other's work instead of starting over. Within a round a node is expanded at
+// most once: a closed node given a shorter path is not put back on the open list but set aside as
+// inconsistent. A round ends as soon as the end's g_cost is no more than the lowest f_cost left on
+// the open list. The next round puts the inconsistent nodes back on the open list, recomputes the
+// f_cost of every open node with the new epsilon and rebuilds the heap, then reopens the closed
+// nodes, so only the nodes whose costs could still change get expanded again.
+//
+// After each round the path is at most epsilon times the shortest, but usually much less: no path
+// can cost less than the lowest uninflated g_cost + h_cost of a node left open or inconsistent, so
+// the end's g_cost over that is a tighter bound, and a bound of 1 means the path is the shortest.
+//
+// Epsilons and bounds are kept in hundredths (ARA_EPSILON_SCALE), so they stay integers like
+// every other cost. The first round always runs to the end, so there is a path to return however
+// small the budget. The open list is always a binary heap, as the heap is rebuilt between rounds.
+
+#define ARA_EPSILON_SCALE 100
+#define ARA_EPSILON 300      // The default first epsilon, 3.
+#define ARA_EPSILON_STEP 50  // The default step epsilon is lowered by after each round, 0.5.
+#define ARA_CHECK_TIME 1024  // Nodes expanded between looks at the clock.
+#define INIT_ARA_NODES 64
+
+typedef struct {
+    int epsilon;      // The first round's epsilon, in hundredths.
+    int epsilon_step; // How much epsilon is lowered after each round, in hundredths.
+    double budget;    // Seconds a search may spend improving its path after the first round.
+} AraOptions;
+
+// One path found by a round.
+typedef struct {
+    int path_cost;
+    int epsilon;         // The round's epsilon, in hundredths.
+    int bound;           // How many times the shortest path this one costs at most, in hundredths.
+    int64_t num_expanded; // Nodes expanded by every round so far.
+    double seconds;      // Time since the search started.
+} AraSolution;
+
+// An ARA* search: a Search, plus the nodes each round closes and sets aside, and the paths found.
+typedef struct {
+    Search search;
+    AraOptions* options;
+    int epsilon;
+    uint32_t* closed;      // Nodes closed in this round, to reopen in the next.
+    int num_closed;
+    int closed_size;
+    uint32_t* incons;      // Closed nodes given a shorter path in this round.
+    int num_incons;
+    int incons_size;
+    AraSolution* solutions;
+    int num_solutions;
+    int solutions_size;
+} AraSearch;
+
+// Function declarations --------------------------------------------------------------------------
+
+void init_ara_search(AraSearch* ara, Grid* grid, Landmarks* landmarks, AraOptions* options);
+int find_ara_path(AraSearch* ara, uint32_t start_index, uint32_t end_index);
+int improve_ara_path(AraSearch* ara, double deadline);
+void relax_ara_node(AraSearch* ara, uint32_t next_index, uint32_t curr_index);
+int get_ara_bound(AraSearch* ara);
+void add_ara_solution(AraSearch* ara, int bound, double start_time);
+void start_ara_round(AraSearch* ara);
+int get_inflated_cost(Node* node, int epsilon);
+void push_ara_node(uint32_t** list, int* len, int* curr_size, uint32_t index);
+void free_ara_search(AraSearch* ara);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void init_ara_search(AraSearch* ara, Grid* grid, Landmarks* landmarks, AraOptions* options) {
+    /* Allocates an ARA* search over a grid, whose heuristic uses landmarks unless they are NULL,
+    run with the given options. */
+
+    init_search(&ara->search, grid, NULL, BINARY_HEAP);
+    ara->search.landmarks = landmarks;
+    ara->options = options;
+    ara->closed_size = ara->incons_size = ara->solutions_size = INIT_ARA_NODES;
+    ara->closed = malloc(ara->closed_size * sizeof *(ara->closed));
+    ara->incons = malloc(ara->incons_size * sizeof *(ara->incons));
+    ara->solutions = malloc(ara->solutions_size * sizeof *(ara->solutions));
+}
+
+int find_ara_path(AraSearch* ara, uint32_t start_index, uint32_t end_index) {
+    /* Finds a path from start_index to end_index, then keeps improving it with lower epsilons
+    until it is the shortest or the budget runs out. Every path found is saved in ara->solutions.
+    Returns the cost of the last one, or -1 if there is no path. */
+
+    Search* search = &ara->search;
+    double start_time = get_time();
+    double deadline = start_time + ara->options->budget;
+
+    ara->epsilon = ara->options->epsilon;
+    ara->num_closed = ara->num_incons = ara->num_solutions = 0;
+    reset_search(search, start_index, end_index);
+    if (!same_component(search->grid, start_index, end_index)) {
+        return -1;
+    }
+
+    // reset_search gave the start an uninflated f_cost, and left it unanalyzed.
+    Node* start_node = get_node(search, start_index);
+    start_node->analyzed_once = 1;
+    start_node->f_cost = get_inflated_cost(start_node, ara->epsilon);
+
+    while (1) {
+        // The first round has no path to fall back on, so it isn't given a deadline.
+        int result = improve_ara_path(ara, ara->num_solutions ? deadline : INFINITY);
+        if (result == -1) {
+            return -1;
+        } else if (result == 0) {
+            break; // Out of time, so keep the last round's path.
+        }
+
+        int bound = get_ara_bound(ara);
+        add_ara_solution(ara, bound, start_time);
+        if (bound <= ARA_EPSILON_SCALE || get_time() >= deadline) {
+            break;
+        }
+
+        ara->epsilon -= ara->options->epsilon_step;
+        if (ara->epsilon > bound) {
+            ara->epsilon = bound; // A higher epsilon could only find the same path again.
+        }
+        if (ara->epsilon < ARA_EPSILON_SCALE) {
+            ara->epsilon = ARA_EPSILON_SCALE;
+        }
+        start_ara_round(ara);
+    }
+
+    return ara->solutions[ara->num_solutions - 1].path_cost;
+}
+
+int improve_ara_path(AraSearch* ara, double deadline) {
+    /* Runs one round: expands open nodes until the end's g_cost is no more than the lowest f_cost
+    on the open list. Returns 1 once it is, 0 if the deadline passes first, or -1 if the open list
+    runs out before the end is reached (there is no path). */
+
+    Search* search = &ara->search;
+    Node* end_node = get_node(search, search->end_index);
+
+    for (int num_expanded = 1; ; num_expanded++) {
+        Node* node = peek_open_node(&search->open_nodes);
+        if (end_node->analyzed_once && (node == NULL || end_node->g_cost <= node->f_cost)) {
+            return 1;
+        } else if (node == NULL) {
+            return -1;
+        } else if (num_expanded % ARA_CHECK_TIME == 0 && get_time() >= deadline) {
+            return 0;
+        }
+
+        pop_open_node(&search->open_nodes);
+        node->is_open = 0;
+        search->num_expanded++;
+        uint32_t index = node_index(search, node);
+        push_ara_node(&ara->closed, &ara->num_closed, &ara->closed_size, index);
+
+        // Closed nodes are neighbors too, as they can be given a shorter path.
+        uint32_t neighbors[NUM_SURR];
+        int num_neighbors = get_open_neighbors(search->grid, index, neighbors);
+        for (int i = 0; i < num_neighbors; i++) {
+            relax_ara_node(ara, neighbors[i], index);
+        }
+    }
+}
+
+void relax_ara_node(AraSearch* ara, uint32_t next_index, uint32_t curr_index) {
+    /* Gives a neighbor of the node just expanded the path through it if that is shorter. An open
+    node goes on the open list, and a closed one is set aside until the next round. */
+
+    Search* search = &ara->search;
+    Node* next_node = get_node(search, next_index);
+    Node* curr_node = get_node(search, curr_index);
+    int g_cost = get_step_cost(search->grid, next_index, curr_index) + curr_node->g_cost;
+
+    if (!next_node->analyzed_once) {
+        next_node->analyzed_once = 1;
+        next_node->h_cost = get_heuristic(search, next_index);
+    } else if (g_cost < next_node->g_cost) {
+        if (next_node->is_open) {
+            search->num_decreased++;
+        } else {
+            search->num_reopened++;
+        }
+    } else {
+        return;
+    }
+
+    int old_f_cost = next_node->f_cost;
+    next_node->g_cost = g_cost;
+    next_node->f_cost = get_inflated_cost(next_node, ara->epsilon);
+    next_node->prev_index = curr_index;
+
+    if (!next_node->is_open) {
+        // Closed nodes have no place on the open list, so heap_index marks them as set aside.
+        if (next_node->heap_index == -1) {
+            next_node->heap_index = 0;
+            push_ara_node(&ara->incons, &ara->num_incons, &ara->incons_size, next_index);
+        }
+    } else if (next_node->heap_index == -1) {
+        add_open_node(next_node, &search->open_nodes);
+    } else {
+        update_open_node(next_node, old_f_cost, &search->open_nodes);
+    }
+}
+
+int get_ara_bound(AraSearch* ara) {
+    /* Returns how many times the shortest path the end's g_cost is at most, in hundredths, from
+    the lowest uninflated f_cost of the nodes that are open or set aside. */
+
+    Search* search = &ara->search;
+    Heap* open_nodes = &search->open_nodes;
+    int64_t lowest = INT64_MAX;
+    for (int i = 0; i < open_nodes->num_open_nodes; i++) {
+        Node* node = open_nodes->nodes[i];
+        if (node->g_cost + node->h_cost < lowest) {
+            lowest = node->g_cost + node->h_cost;
+        }
+    }
+    for (int i = 0; i < ara->num_incons; i++) {
+        Node* node = &search->nodes[ara->incons[i]];
+        if (node->g_cost + node->h_cost < lowest) {
+            lowest = node->g_cost + node->h_cost;
+        }
+    }
+
+    int64_t path_cost = search->nodes[search->end_index].g_cost;
+    if (path_cost <= lowest) {
+        return ARA_EPSILON_SCALE; // Nothing left could lead to a shorter path.
+    }
+
+    // Round up, so the bound is never below the true ratio.
+    int64_t bound = (path_cost * ARA_EPSILON_SCALE + lowest - 1) / lowest;
+    return (bound < ara->epsilon) ? (int) bound : ara->epsilon;
+}
+
+void add_ara_solution(AraSearch* ara, int bound, double start_time) {
+    // Saves the path the last round found.
+
+    if (ara->num_solutions == ara->solutions_size) {
+        ara->solutions_size *= 2;
+        ara->solutions = realloc(ara->solutions, ara->solutions_size * sizeof *(ara->solutions));
+    }
+
+    AraSolution* solution = &ara->solutions[ara->num_solutions++];
+    solution->path_cost = ara->search.nodes[ara->search.end_index].g_cost;
+    solution->epsilon = ara->epsilon;
+    solution->bound = bound;
+    solution->num_expanded = ara->search.num_expanded;
+    solution->seconds = get_time() - start_time;
+}
+
+void start_ara_round(AraSearch* ara) {
+    /* Prepares the next round with the new epsilon: puts the nodes set aside back on the open
+    list, recomputes every open node's f_cost and rebuilds the heap, and reopens the closed
+    nodes. */
+
+    Search* search = &ara->search;
+    Heap* open_nodes = &search->open_nodes;
+
+    for (int i = 0; i < ara->num_incons; i++) {
+        Node* node = &search->nodes[ara->incons[i]];
+        node->heap_index = -1;
+        add_open_node(node, open_nodes);
+    }
+    ara->num_incons = 0;
+
+    for (int i = 0; i < open_nodes->num_open_nodes; i++) {
+        open_nodes->nodes[i]->f_cost = get_inflated_cost(open_nodes->nodes[i], ara->epsilon);
+    }
+    node_heap_heapify(open_nodes->nodes, open_nodes->num_open_nodes);
+
+    for (int i = 0; i < ara->num_closed; i++) {
+        search->nodes[ara->closed[i]].is_open = 1;
+    }
+    ara->num_closed = 0;
+}
+
+int get_inflated_cost(Node* node, int epsilon) {
+    // Returns a node's g_cost plus its h_cost inflated by epsilon (in hundredths).
+    return node->g_cost + (int) ((int64_t) node->h_cost * epsilon / ARA_EPSILON_SCALE);
+}
+
+void push_ara_node(uint32_t** list, int* len, int* curr_size, uint32_t index) {
+    // Appends a cell index to a growing list.
+
+    if (*len == *curr_size) {
+        *curr_size *= 2;
+        *list = realloc(*list, *curr_size * sizeof **(list));
+    }
+    (*list)[(*len)++] = index;
+}
+
+void free_ara_search(AraSearch* ara) {
+    free_search(&ara->search);
+    free(ara->closed);
+    free(ara->incons);
+    free(ara->solutions);
+}
@@ -0,0 +1,181 @@
+// The types shared by the search modes. The grid (the map) is loaded once and never written to
+// while searching, while everything a search writes lives in a Search, so several searches can
+// run over the same grid at once. The functions declared here are defined in main.c.
+
+#define START 'S'
+#define END 'E'
+#define OBSTACLE 'Z'
+#define EMPTY '_'
+#define NEW_LINE '\n'
+#define PATH_CHAR '.'
+
+// The number of neighbors surrounding a node usually (except edge and corner
+// nodes).
+#define NUM_SURR 8
+#define INIT_HEAP_SIZE 16
+
+// How searches move between cells, chosen with the --moves command line option, or fixed at build
+// time by defining MOVES as one of these (e.g. -DMOVES=MOVES_4), which leaves only that one in
+// get_neighbors.
+#define MOVES_4 0            // Up, down, left and right.
+#define MOVES_8 1            // Diagonally too, even between the corners of two obstacles.
+#define MOVES_8_NO_CORNERS 2 // Diagonally too, but only if both cells beside the step are open.
+
+// How cells are numbered, fixed at build time by defining LAYOUT as one of these (e.g.
+// -DLAYOUT=LAYOUT_TILED). See map.h.
+#define LAYOUT_ROW_MAJOR 0 // Row by row.
+#define LAYOUT_TILED 1     // In TILE_SIZE x TILE_SIZE tiles, each row by row, and tiles row by row.
+#ifndef LAYOUT
+    #define LAYOUT LAYOUT_ROW_MAJOR
+#endif
+#define TILE_SIZE 8 // So a tile's 64 cells take up one word of the obstacle bitmap.
+
+// Functions that must be inlined into each caller to be specialized for it, such as
+// find_neighbors for each kind of move.
+#ifdef __GNUC__
+    #define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+    #define ALWAYS_INLINE inline
+#endif
+
+// Open list backends, chosen with the --open-list command line option.
+#define BINARY_HEAP 0
+#define BUCKET_QUEUE 1
+
+// The end_index of a search with no end, which floods every cell it can reach (see alt.h).
+#define NO_INDEX UINT32_MAX
+
+#define PRECISION_MULT 10
+#define SQRT_2 (int) (PRECISION_MULT * 1.4142)
+
+// The connected components of a grid's open cells (see components.h).
+typedef struct {
+    uint32_t* labels;  // The label of each cell, or 0 for obstacles.
+    uint32_t* parents; // Union-find over the labels: cells are connected if their roots match.
+    uint32_t* sizes;   // The number of cells in the component of each root.
+    uint32_t num_labels;
+    uint32_t curr_size;
+} Components;
+
+// The ends of a map with more than one 'E', for searches for the nearest of them (see goals.h).
+typedef struct {
+    int row;
+    int col;
+} GoalPoint;
+
+typedef struct {
+    GoalPoint* points;  // Every end, ordered as a k-d tree once indexed.
+    uint32_t num_goals;
+    uint32_t curr_size;
+    uint64_t* bitmap;   // The bit of every end's cell set, or NULL if there is only one end.
+} Goals;
+
+// The map (see map.h). Cells are indexed as LAYOUT says (see get_index), and held as a bitmap with
+// the bit of cell i (bit i % 64 of word i / 64) set if it is an obstacle. Maps with terrain also
+// keep the cost of each cell, which every step into or out of it is weighted by (see
+// get_step_cost).
+typedef struct {
+    int num_rows;
+    int num_cols;
+    uint32_t num_cells;   // The number of cell indices, counting the padding of partial tiles.
+    int num_tile_cols;    // The number of tiles across the map, with LAYOUT_TILED.
+    uint64_t* obstacles;
+    uint8_t* costs;       // The terrain cost of each cell, or NULL if every cell costs 1.
+    int min_cost;         // The lowest cost of any open cell, which heuristics are scaled by.
+    int moves;            // MOVES_4, MOVES_8 or MOVES_8_NO_CORNERS.
+    uint32_t start_index; // The map's 'S' cell, or NO_INDEX if it has none.
+    uint32_t end_index;   // The map's last 'E' cell, or NO_INDEX if it has none.
+    uint64_t* path;       // The cells of the path drawn over the map, or NULL before one is.
+    void* file;           // The mapped file the obstacles are read from, or NULL if allocated.
+    size_t file_size;
+    Components components;
+    Goals goals;          // Every 'E' cell.
+} Grid;
+
+// Landmark distances for the ALT heuristic (see alt.h), mapped from a file made ahead of time.
+typedef struct {
+    int num_landmarks;
+    uint32_t* landmark_index;
+    uint32_t* distances; // Landmark i's distance to cell c is at c * num_landmarks + i.
+    void* file;
+    size_t file_size;
+} Landmarks;
+
+// The open list. Either a single binary heap of all open nodes, or a bucket queue (see bucket.h).
+typedef struct {
+    int backend;
+    Node** nodes;
+    int curr_size;
+    int num_open_nodes;
+    BucketQueue buckets;
+    int num_pushes;
+    int num_pops;
+    int64_t num_sift_levels; // Levels moved by nodes sifting up or down its heaps, in total.
+    int max_sift_depth;      // The most levels a single push, pop or update moved a node.
+    int peak_open_nodes;
+} Heap;
+
+// The state of one search over a grid: the search fields (Node) of every cell, indexed like the
+// grid's cells, and the open list. Each search over the same Search gets a new generation, and a
+// node's fields only count if they are stamped with the current one. Otherwise the node is
+// treated as untouched, so starting a new search doesn't need to reset every node.
+typedef struct {
+    Grid* grid;
+    JumpMap* jump_map; // NULL unless expanding nodes with jump point search.
+    Landmarks* landmarks; // NULL unless using the ALT heuristic.
+    Goals* goals;      // NULL unless searching for the nearest of many ends (see goals.h).
+    Node* nodes;
+    uint32_t generation;
+    Heap open_nodes;
+    uint32_t start_index;
+    uint32_t end_index;
+    int balanced;      // Set for either side of a bidirectional search (see bidir.h).
+    int num_expanded;
+    int num_reopened;  // Times a closed node was given a shorter path and opened again.
+    int num_decreased; // Times a node still open was given a shorter path (a decrease-key).
+} Search;
+
+// Function declarations --------------------------------------------------------------------------
+
+void init_search(Search* search, Grid* grid, JumpMap* jump_map, int backend);
+void reset_search(Search* search, uint32_t start_index, uint32_t end_index);
+int find_path(Search* search);
+Node* get_node(Search* search, uint32_t index);
+int get_neighbors(Search* search, uint32_t index, uint32_t* neighbors);
+int get_open_neighbors(Grid* grid, uint32_t index, uint32_t* neighbors);
+static ALWAYS_INLINE int pick_neighbors(Grid* grid, Search* search, uint32_t index,
+    uint32_t* neighbors);
+static ALWAYS_INLINE int find_neighbors(Grid* grid, Search* search, uint32_t index,
+    uint32_t* neighbors, int moves);
+int find_edge_neighbors(Grid* grid, Search* search, uint32_t index, uint32_t* neighbors,
+    int moves);
+static ALWAYS_INLINE int is_reachable(Grid* grid, Search* search, uint32_t index);
+int analyze_step(Search* search);
+int analyze_jump_step(Search* search);
+int visit_node(Search* search, uint32_t next_index, uint32_t curr_index);
+int analyze_node(Search* search, uint32_t next_index, uint32_t curr_index);
+int get_heuristic(Search* search, uint32_t index);
+int get_estimate(Search* search, uint32_t index1, uint32_t index2);
+int get_distance(Grid* grid, uint32_t index1, uint32_t index2);
+int get_min_distance(Grid* grid, uint32_t index1, uint32_t index2);
+int get_step_cost(Grid* grid, uint32_t index1, uint32_t index2);
+uint32_t node_index(Search* search, Node* node);
+int num_min(int a, int b);
+int num_sign(int a);
+void load_jump_map(Grid* grid, JumpMap* jump_map);
+void print_grid(Search* search);
+void print_node_list(Grid* grid, uint32_t* list, int len);
+void init_open_nodes(Heap* open_nodes, int backend);
+void clear_open_nodes(Heap* open_nodes);
+void add_open_node(Node* node, Heap* open_nodes);
+Node* pop_open_node(Heap* open_nodes);
+Node* peek_open_node(Heap* open_nodes);
+int count_open_nodes(Heap* open_nodes);
+void update_open_node(Node* node, int old_f_cost, Heap* open_nodes);
+void count_sift(Heap* open_nodes, int num_levels);
+void free_search(Search* search);
+void draw_path(Search* search);
+void trace_path(Search* search);
+void clear_screen();
+
+// Function declarations end ----------------------------------------------------------------------
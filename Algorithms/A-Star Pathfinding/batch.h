@@ -0,0 +1,297 @@
+// Batch mode: answers many start/end queries over one map. The map is loaded once and shared by
+// every thread, and only ever read. Each thread owns a Search (its own node array and open list)
+// and keeps reusing it for every query it takes. With HDA* (see hda.h), the queries are instead
+// answered one at a time, each by all of the HDA* search's threads. With a flow field (see
+// flowfield.h), every query must end at the field's end, and is answered by following it. With
+// ARA* (see ara.h), each query gets the whole time budget, and is answered with its last path.
+//
+// The query file has one query per line: "start_row start_col end_row end_col".
+//
+// After the answers, the process's peak resident memory is printed (on Linux, where it can be read
+// from /proc), for benchmarks to record (see bench.py).
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define INIT_QUERIES 1024
+
+typedef struct {
+    uint32_t start_index;
+    uint32_t end_index;
+    int path_cost;     // -1 if there is no path, or if either end is an obstacle.
+    Counts counts;
+} Query;
+
+// What every worker thread shares: the map, the queries, and the index of the next query no
+// thread has taken yet.
+typedef struct {
+    Grid* grid;
+    JumpMap* jump_map;
+    Landmarks* landmarks;
+    Hpa* hpa;
+    Hda* hda;
+    FlowField* flow;
+    AraOptions* ara;
+    int backend;
+    int bidirectional;
+    Query* queries;
+    int num_queries;
+    atomic_int next_query;
+} Batch;
+
+// Function declarations --------------------------------------------------------------------------
+
+int run_batch(Grid* grid, JumpMap* jump_map, Landmarks* landmarks, Hpa* hpa, Hda* hda,
+    FlowField* flow, AraOptions* ara, int backend, int bidirectional, char* query_file,
+    int num_threads, Stats* stats);
+int load_queries(char* query_file, Grid* grid, Query** queries);
+void* batch_worker(void* arg);
+void answer_query(Search* search, Search* backward, Query* query);
+void answer_hpa_query(HpaSearch* search, Query* query);
+void answer_hda_query(Hda* hda, Query* query);
+void answer_flow_query(FlowField* flow, Grid* grid, Query* query);
+void answer_ara_query(AraSearch* search, Query* query);
+long get_peak_memory();
+
+// Function declarations end ----------------------------------------------------------------------
+
+int run_batch(Grid* grid, JumpMap* jump_map, Landmarks* landmarks, Hpa* hpa, Hda* hda,
+    FlowField* flow, AraOptions* ara, int backend, int bidirectional, char* query_file,
+    int num_threads, Stats* stats) {
+    /* Answers every query in query_file on num_threads threads (or one per core if num_threads
+    is 0), then prints each query's path cost and node counts, and the throughput. If stats is
+    not NULL, the queries are added to it and it is printed last. */
+
+    Batch batch;
+    batch.grid = grid;
+    batch.jump_map = jump_map;
+    batch.landmarks = landmarks;
+    batch.hpa = hpa;
+    batch.hda = hda;
+    batch.flow = flow;
+    batch.ara = ara;
+    batch.backend = backend;
+    batch.bidirectional = bidirectional;
+    batch.num_queries = load_queries(query_file, grid, &batch.queries);
+    if (batch.num_queries == -1) {
+        printf("Could not read queries from '%s'. Exiting...\n", query_file);
+        return 0;
+    }
+    for (int i = 0; flow != NULL && i < batch.num_queries; i++) {
+        if (batch.queries[i].end_index != flow->end_index) {
+            printf("Query %d doesn't end at the flow field's end. Exiting...\n", i);
+            free(batch.queries);
+            return 0;
+        }
+    }
+    atomic_init(&batch.next_query, 0);
+
+    if (num_threads <= 0) {
+        num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (hda != NULL) {
+        num_threads = 1; // The HDA* search brings its own threads, and can only run one query.
+    }
+
+    double start_time = get_time();
+
+    pthread_t* threads = malloc(num_threads * sizeof *(threads));
+    for (int i = 0; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, batch_worker, &batch);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = get_time() - start_time;
+
+    printf("# query path_cost nodes_expanded open_list_pushes open_list_pops\n");
+    for (int i = 0; i < batch.num_queries; i++) {
+        Counts* counts = &batch.queries[i].counts;
+        printf("%d %d %" PRId64 " %" PRId64 " %" PRId64 "\n", i, batch.queries[i].path_cost,
+            counts->num_expanded, counts->num_pushes, counts->num_pops);
+    }
+    if (hda != NULL) {
+        num_threads = hda->num_threads;
+    }
+    printf("# Answered %d queries in %.3f s on %d threads (%.1f queries/s)\n", batch.num_queries,
+        seconds, num_threads, batch.num_queries / seconds);
+    long peak_memory = get_peak_memory();
+    if (peak_memory != -1) {
+        printf("# Peak memory: %ld KB\n", peak_memory);
+    }
+
+    if (stats != NULL) {
+        for (int i = 0; i < batch.num_queries; i++) {
+            add_path(stats, batch.queries[i].path_cost, &batch.queries[i].counts);
+        }
+        stats->num_threads = num_threads;
+        stats->search_time = seconds;
+        print_stats(stats);
+    }
+
+    free(threads);
+    free(batch.queries);
+    return 0;
+}
+
+int load_queries(char* query_file, Grid* grid, Query** queries) {
+    /* Reads every query in query_file into a newly allocated array. Returns the number of
+    queries, or -1 if the file can't be read or a query lies outside of the grid. */
+
+    FILE* fp = fopen(query_file, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    int curr_size = INIT_QUERIES, num_queries = 0;
+    *queries = malloc(curr_size * sizeof **(queries));
+
+    int start_row, start_col, end_row, end_col;
+    while (fscanf(fp, "%d %d %d %d", &start_row, &start_col, &end_row, &end_col) == 4) {
+        if (start_row < 0 || start_row >= grid->num_rows || end_row < 0 ||
+            end_row >= grid->num_rows || start_col < 0 || start_col >= grid->num_cols ||
+            end_col < 0 || end_col >= grid->num_cols) {
+            fclose(fp);
+            free(*queries);
+            return -1;
+        }
+
+        if (num_queries == curr_size) {
+            curr_size *= 2;
+            *queries = realloc(*queries, curr_size * sizeof **(queries));
+        }
+
+        (*queries)[num_queries].start_index = get_index(grid, start_row, start_col);
+        (*queries)[num_queries].end_index = get_index(grid, end_row, end_col);
+        num_queries++;
+    }
+
+    fclose(fp);
+    return num_queries;
+}
+
+void* batch_worker(void* arg) {
+    /* Thread body. Takes queries one at a time until there are none left, answering each with
+    the thread's own search. */
+
+    Batch* batch = arg;
+
+    if (batch->hpa != NULL) {
+        HpaSearch hpa_search;
+        init_hpa_search(&hpa_search, batch->hpa);
+        int i;
+        while ( (i = atomic_fetch_add(&batch->next_query, 1)) < batch->num_queries ) {
+            answer_hpa_query(&hpa_search, &batch->queries[i]);
+        }
+        free_hpa_search(&hpa_search);
+        return NULL;
+    }
+
+    if (batch->hda != NULL) {
+        int i;
+        while ( (i = atomic_fetch_add(&batch->next_query, 1)) < batch->num_queries ) {
+            answer_hda_query(batch->hda, &batch->queries[i]);
+        }
+        return NULL;
+    }
+
+    if (batch->flow != NULL) {
+        int i;
+        while ( (i = atomic_fetch_add(&batch->next_query, 1)) < batch->num_queries ) {
+            answer_flow_query(batch->flow, batch->grid, &batch->queries[i]);
+        }
+        return NULL;
+    }
+
+    if (batch->ara != NULL) {
+        AraSearch ara_search;
+        init_ara_search(&ara_search, batch->grid, batch->landmarks, batch->ara);
+        int i;
+        while ( (i = atomic_fetch_add(&batch->next_query, 1)) < batch->num_queries ) {
+            answer_ara_query(&ara_search, &batch->queries[i]);
+        }
+        free_ara_search(&ara_search);
+        return NULL;
+    }
+
+    Search search, backward;
+    init_search(&search, batch->grid, batch->jump_map, batch->backend);
+    search.landmarks = batch->landmarks;
+    if (batch->bidirectional) {
+        init_search(&backward, batch->grid, NULL, batch->backend);
+        backward.landmarks = batch->landmarks;
+    }
+
+    int i;
+    while ( (i = atomic_fetch_add(&batch->next_query, 1)) < batch->num_queries ) {
+        answer_query(&search, batch->bidirectional ? &backward : NULL, &batch->queries[i]);
+    }
+
+    free_search(&search);
+    if (batch->bidirectional) {
+        free_search(&backward);
+    }
+    return NULL;
+}
+
+void answer_query(Search* search, Search* backward, Query* query) {
+    /* Finds the path of a single query and saves its cost and node counts into it. If backward
+    is not NULL, the path is found with a bidirectional search. Queries whose ends are in
+    different components, or on obstacles, are answered without searching (see components.h). */
+
+    if (backward != NULL) {
+        uint32_t meet_index;
+        query->path_cost = find_bidirectional_path(search, backward, query->start_index,
+            query->end_index, &meet_index);
+        get_bidirectional_counts(search, backward, &query->counts);
+        return;
+    }
+
+    reset_search(search, query->start_index, query->end_index);
+    query->path_cost = find_path(search);
+    get_search_counts(search, &query->counts);
+}
+
+void answer_hpa_query(HpaSearch* search, Query* query) {
+    // Like answer_query, with HPA* (see hpa.h).
+    query->path_cost = find_hpa_path(search, query->start_index, query->end_index);
+    get_hpa_counts(search, &query->counts);
+}
+
+void answer_hda_query(Hda* hda, Query* query) {
+    // Like answer_query, with HDA* (see hda.h).
+    query->path_cost = find_hda_path(hda, query->start_index, query->end_index);
+    get_hda_counts(hda, &query->counts);
+}
+
+void answer_flow_query(FlowField* flow, Grid* grid, Query* query) {
+    // Like answer_query, by following a flow field (see flowfield.h). No nodes are expanded.
+    query->path_cost = follow_flow_field(flow, grid, query->start_index);
+    memset(&query->counts, 0, sizeof query->counts);
+}
+
+void answer_ara_query(AraSearch* search, Query* query) {
+    // Like answer_query, with ARA* (see ara.h).
+    query->path_cost = find_ara_path(search, query->start_index, query->end_index);
+    get_search_counts(&search->search, &query->counts);
+}
+
+long get_peak_memory() {
+    /* Returns the most memory the process has had resident at once since it started, in KB, or -1
+    if it can't be read. */
+
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    char line[256];
+    long peak_memory = -1;
+    while (fgets(line, sizeof line, fp) != NULL) {
+        if (sscanf(line, "VmHWM: %ld kB", &peak_memory) == 1) {
+            break;
+        }
+    }
+    fclose(fp);
+    return peak_memory;
+}
@@ -0,0 +1,201 @@
+# Benchmarks every search mode over a corpus of generated maps and prints one CSV row per map and
+# mode: wall time, nodes expanded, open list pushes and pops, and peak memory use.
+#
+# Maps are made with mapgen (see mapgen.c) from a fixed seed and saved as binary maps (see map.h)
+# in the corpus directory, where later runs reuse them. Each run answers the map's own start and
+# end query, plus --queries random ones between open cells, with a single thread of
+# "main --batch", so the search time excludes loading the map. With --hda-threads, each map is
+# also searched with HDA* (see hda.h) on each of the given numbers of threads, as modes "hda-N",
+# to show how it scales.
+#
+# --tiled runs every mode a second time with a build of main whose cells are numbered in tiles
+# (see map.h), as modes "MODE-tiled", and --perf counts each run's cache and TLB misses with
+# "perf stat". Sizes can be "ROWSxCOLS" as well as one side, for tall and wide maps.
+#
+# Peak memory is the high-water mark of main's resident memory as main itself reports it (see
+# batch.h), since the rusage of a child also counts the memory of the Python process forking it.
+#
+# Build both programs first:
+#   gcc -std=c11 -Wall -O2 -pthread -o main main.c
+#   gcc -std=c11 -Wall -O2 -o mapgen mapgen.c
+#   gcc -std=c11 -Wall -O2 -pthread -DLAYOUT=LAYOUT_TILED -o main_tiled main.c  (for --tiled)
+#
+# Usage: python3 bench.py [--sizes 1024,512x32768] [--types maze,rooms] [--modes heap,jps]
+#                         [--hda-threads 1,2,4,8,16,32,64] [--tiled main_tiled] [--perf]
+#                         [--out f]
+
+import argparse
+import csv
+import mmap
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SIZES = [1024, 2048, 4096, 8192, 16384]
+TYPES = ["random", "maze", "rooms", "open", "terrain"]
+MODES = {
+    "heap": ["--open-list", "heap"],
+    "bucket": ["--open-list", "bucket"],
+    "jps": ["--jps"],
+    "bidir": ["--bidir"],
+    "hpa": ["--hpa", "16"],
+}
+COLUMNS = ["map", "type", "rows", "cols", "mode", "queries", "path_cost", "search_s", "total_s",
+           "nodes_expanded", "open_list_pushes", "open_list_pops", "peak_rss_kb", "cache_misses",
+           "dtlb_misses"]
+PERF_EVENTS = ["cache-misses", "dTLB-load-misses"]
+
+MAP_HEADER = struct.Struct("<4siiII12x") # MapHeader in map.h.
+NO_INDEX = 2**32 - 1
+
+
+def make_map(args, map_type, size):
+    """Returns the path of the binary map of a type and size ("N" or "ROWSxCOLS"), generating it
+    first if needed."""
+    path = os.path.join(args.corpus, "{}_{}.bmap".format(map_type, size))
+    if os.path.exists(path):
+        return path
+
+    num_rows, _, num_cols = size.partition("x")
+    os.makedirs(args.corpus, exist_ok=True)
+    with tempfile.NamedTemporaryFile(dir=args.corpus, suffix=".map") as text_map:
+        subprocess.run([args.mapgen, map_type, num_rows, num_cols or num_rows, str(args.seed)],
+                       stdout=text_map, check=True)
+        subprocess.run([args.main, "--convert", path, text_map.name],
+                       stdout=subprocess.DEVNULL, check=True)
+    return path
+
+
+def make_queries(path, num_random, seed):
+    """Writes a query file for a binary map: its start and end, then num_random queries between
+    random open cells. Returns the file's path and the number of queries."""
+
+    # The map is mapped rather than read, so only the bytes of the cells tried are loaded.
+    with open(path, "rb") as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    _, num_rows, num_cols, start_index, end_index = MAP_HEADER.unpack_from(data)
+
+    def is_open(index):
+        return not (data[MAP_HEADER.size + index // 8] >> (index % 8)) & 1
+
+    queries = []
+    if start_index != NO_INDEX and end_index != NO_INDEX:
+        queries.append((start_index, end_index))
+
+    rng = random.Random(seed)
+    while len(queries) < num_random + (start_index != NO_INDEX and end_index != NO_INDEX):
+        ends = [rng.randrange(num_rows * num_cols) for _ in range(2)]
+        if is_open(ends[0]) and is_open(ends[1]):
+            queries.append(tuple(ends))
+
+    query_path = path + ".queries"
+    with open(query_path, "w") as f:
+        for start, end in queries:
+            f.write("{} {} {} {}\n".format(start // num_cols, start % num_cols,
+                                           end // num_cols, end % num_cols))
+    data.close()
+    return query_path, len(queries), num_rows, num_cols
+
+
+def run_mode(args, path, query_path, mode):
+    """Answers every query of a map with one mode. Returns the path cost of the first query, the
+    search and total times, the summed node counts, the peak RSS in KB, and the cache and TLB
+    misses (with --perf)."""
+
+    main = args.main
+    if mode.endswith("-tiled"):
+        main, mode = args.tiled, mode[:-len("-tiled")]
+    command = [main, "--batch", query_path, "--threads", "1"] + MODES[mode] + [path]
+    perf_file = tempfile.NamedTemporaryFile(mode="w+")
+    if args.perf:
+        command = ["perf", "stat", "-x,", "-o", perf_file.name, "-e", ",".join(PERF_EVENTS)] + \
+            command
+    with tempfile.TemporaryFile(mode="w+") as output:
+        start_time = time.perf_counter()
+        process = subprocess.run(command, stdout=output)
+        total_time = time.perf_counter() - start_time
+        output.seek(0)
+        lines = output.read().splitlines()
+
+    # perf stat -x, writes "count,unit,event,..." lines.
+    misses = {}
+    for line in perf_file.read().splitlines():
+        fields = line.split(",")
+        if len(fields) > 2 and fields[2] in PERF_EVENTS and fields[0].isdigit():
+            misses[fields[2]] = int(fields[0])
+    perf_file.close()
+
+    path_cost, search_time, peak_memory = None, None, ""
+    counts = [0, 0, 0]
+    for line in lines:
+        fields = line.split()
+        if line.startswith("# Answered"):
+            search_time = float(fields[5])
+        elif line.startswith("# Peak memory:"):
+            peak_memory = int(fields[3])
+        elif fields and not line.startswith("#") and len(fields) == 5:
+            if path_cost is None:
+                path_cost = int(fields[1])
+            for i in range(3):
+                counts[i] += int(fields[2 + i])
+
+    if process.returncode != 0 or search_time is None:
+        sys.exit("'{}' failed:\n{}".format(" ".join(command), "\n".join(lines)))
+
+    return [path_cost, "{:.6f}".format(search_time), "{:.6f}".format(total_time)] + counts + \
+        [peak_memory] + [misses.get(event, "") for event in PERF_EVENTS]
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Benchmark the search modes on generated maps.")
+    parser.add_argument("--main", default=os.path.join(here, "main"))
+    parser.add_argument("--mapgen", default=os.path.join(here, "mapgen"))
+    parser.add_argument("--corpus", default=os.path.join(here, "bench_maps"))
+    parser.add_argument("--sizes", default=",".join(map(str, SIZES)))
+    parser.add_argument("--types", default=",".join(TYPES))
+    parser.add_argument("--modes", default=",".join(MODES))
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--queries", type=int, default=0, help="random queries per map")
+    parser.add_argument("--hda-threads", default="", help="thread counts to run HDA* with")
+    parser.add_argument("--tiled", help="a build of main with -DLAYOUT=LAYOUT_TILED to compare")
+    parser.add_argument("--perf", action="store_true", help="count misses with perf stat")
+    parser.add_argument("--out", help="CSV file to write (standard output by default)")
+    args = parser.parse_args()
+
+    modes = args.modes.split(",")
+    for mode in modes:
+        if mode not in MODES:
+            parser.error("unknown mode '{}' (expected {})".format(mode, ", ".join(MODES)))
+    for num_threads in filter(None, args.hda_threads.split(",")):
+        MODES["hda-" + num_threads] = ["--hda", num_threads]
+        modes.append("hda-" + num_threads)
+    if args.tiled:
+        modes += [mode + "-tiled" for mode in modes]
+
+    out = open(args.out, "w", newline="") if args.out else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(COLUMNS)
+
+    for size in args.sizes.split(","):
+        for map_type in args.types.split(","):
+            path = make_map(args, map_type, size)
+            query_path, num_queries, num_rows, num_cols = make_queries(path, args.queries,
+                                                                      args.seed)
+            for mode in modes:
+                if mode.removesuffix("-tiled") == "jps" and map_type == "terrain":
+                    continue # Jump point search needs every open cell to cost the same.
+                writer.writerow([os.path.basename(path), map_type, num_rows, num_cols, mode,
+                                 num_queries] + run_mode(args, path, query_path, mode))
+                out.flush()
+
+    if args.out:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+// Bidirectional A*: one search forward from the start towards the end, and one backward from the
+// end towards the start, expanding the side with the smaller open list each step. Whenever a node
+// gets a shorter path on one side and has already been reached by the other, the two halves make
+// a path from start to end, and the cheapest one found so far is kept.
+//
+// Both sides use the same "balanced" heuristic (Ikeda et al., 1994): half the difference between
+// the octile distance to their own goal and to the other side's goal, which is the forward
+// heuristic's negative on the backward side (give or take the rounding in get_heuristic). This
+// keeps both heuristics consistent with each other, and gives a much earlier stopping rule than
+// using the plain octile distance on each side: once the lowest f_costs of the two open lists
+// add up to at least the cost of the cheapest path found, no path left to find can be cheaper,
+// so it is optimal.
+
+// Function declarations --------------------------------------------------------------------------
+
+int find_bidirectional_path(Search* forward, Search* backward, uint32_t start_index,
+    uint32_t end_index, uint32_t* meet_index);
+void analyze_bidirectional_step(Search* search, Search* other, int* best_cost,
+    uint32_t* meet_index);
+int is_reached(Search* search, uint32_t index);
+void join_paths(Search* forward, Search* backward, uint32_t meet_index);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int find_bidirectional_path(Search* forward, Search* backward, uint32_t start_index,
+    uint32_t end_index, uint32_t* meet_index) {
+    /* Runs a bidirectional search for a path from start_index to end_index, using forward and
+    backward as the two sides. Returns the cost of the shortest path and saves the node where the
+    two halves meet into meet_index, or returns -1 if there is no path. */
+
+    forward->balanced = backward->balanced = 1;
+    reset_search(forward, start_index, end_index);
+    reset_search(backward, end_index, start_index);
+
+    int best_cost = -1;
+
+    if (start_index == end_index) {
+        *meet_index = start_index;
+        return 0;
+    }
+
+    if (!same_component(forward->grid, start_index, end_index)) {
+        return -1;
+    }
+
+    while (1) {
+        Node* forward_top = peek_open_node(&forward->open_nodes);
+        Node* backward_top = peek_open_node(&backward->open_nodes);
+
+        // One side has run out of nodes, so every path it could be part of has been found.
+        if (forward_top == NULL || backward_top == NULL) {
+            break;
+        }
+
+        if (best_cost != -1 && forward_top->f_cost + backward_top->f_cost >= best_cost) {
+            break;
+        }
+
+        if (count_open_nodes(&forward->open_nodes) <= count_open_nodes(&backward->open_nodes)) {
+            analyze_bidirectional_step(forward, backward, &best_cost, meet_index);
+        } else {
+            analyze_bidirectional_step(backward, forward, &best_cost, meet_index);
+        }
+    }
+
+    return best_cost;
+}
+
+void analyze_bidirectional_step(Search* search, Search* other, int* best_cost,
+    uint32_t* meet_index) {
+    /* Like analyze_step for one side of a bidirectional search. Each neighbor that gets a shorter
+    path and has been reached by the other side is checked as a meeting point. */
+
+    Node* node = pop_open_node(&search->open_nodes);
+    uint32_t index = node_index(search, node);
+    node->is_open = 0;
+
+    // If the other side has already expanded this node, the path through it was checked when
+    // the node was reached on this side, and its neighbors are already covered by the other side.
+    if (is_reached(other, index) && !get_node(other, index)->is_open) {
+        return;
+    }
+
+    search->num_expanded++;
+
+    uint32_t neighbors[NUM_SURR];
+    int num_neighbors = get_neighbors(search, index, neighbors);
+
+    for (int i = 0; i < num_neighbors; i++) {
+        if (!visit_node(search, neighbors[i], index) || !is_reached(other, neighbors[i])) {
+            continue;
+        }
+
+        int cost = get_node(search, neighbors[i])->g_cost + get_node(other, neighbors[i])->g_cost;
+        if (*best_cost == -1 || cost < *best_cost) {
+            *best_cost = cost;
+            *meet_index = neighbors[i];
+        }
+    }
+}
+
+int is_reached(Search* search, uint32_t index) {
+    // Returns whether a search has found any path to a node yet.
+    return index == search->start_index || get_node(search, index)->analyzed_once;
+}
+
+void join_paths(Search* forward, Search* backward, uint32_t meet_index) {
+    /* Points the forward search's nodes on the backward half of the path (from the meeting node
+    to the end) back towards the meeting node, so the whole path can be followed from the end
+    back to the start in the forward search. */
+
+    uint32_t curr_index = meet_index;
+    while (curr_index != backward->start_index) {
+        uint32_t next_index = get_node(backward, curr_index)->prev_index;
+        get_node(forward, next_index)->prev_index = curr_index;
+        curr_index = next_index;
+    }
+}
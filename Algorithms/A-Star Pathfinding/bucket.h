@@ -0,0 +1,179 @@
+// A bucket queue open list for integer f_costs. Every cost used by the search is a small integer
+// (multiples of PRECISION_MULT and SQRT_2), so nodes can be kept in an array of buckets indexed by
+// f_cost instead of one big heap. Only a narrow band of f_costs is ever open at the same time, so
+// the buckets form a circular window of num_buckets keys that starts at the lowest open f_cost and
+// doubles in size whenever a key falls outside of it.
+//
+// Nodes that share an f_cost are kept in a small heap inside their bucket (made with DEFINE_HEAP in
+// heap.h), so ties are broken on h_cost exactly like with the single heap. These heaps only ever
+// hold one slice of the frontier, so pushes and pops stay close to O(1). As every node in a bucket
+// has the same f_cost, they only compare h_costs, and are binary since they are never deep.
+
+#define INIT_BUCKETS 32
+#define INIT_BUCKET_SIZE 4
+
+typedef struct {
+    Node** nodes;
+    int curr_size;
+    int num_nodes;
+} Bucket;
+
+typedef struct {
+    Bucket* buckets;
+    int num_buckets; // Always a power of 2, so that key % num_buckets is key & (num_buckets - 1).
+    int min_key;     // No bucket below this key holds any nodes.
+    int max_key;     // No bucket above this key holds any nodes.
+    int num_nodes;
+} BucketQueue;
+
+// Function declarations --------------------------------------------------------------------------
+
+static inline int bucket_before(Node* a, Node* b);
+void init_buckets(BucketQueue* queue);
+int push_bucket(BucketQueue* queue, Node* node);
+Node* pop_bucket(BucketQueue* queue, int* num_levels);
+Node* peek_bucket(BucketQueue* queue);
+int update_bucket(BucketQueue* queue, Node* node, int old_key);
+Bucket* get_bucket(BucketQueue* queue, int key);
+void grow_buckets(BucketQueue* queue, int min_key, int max_key);
+void clear_buckets(BucketQueue* queue);
+void free_buckets(BucketQueue* queue);
+
+// Function declarations end ----------------------------------------------------------------------
+
+static inline int bucket_before(Node* a, Node* b) {
+    return (a->h_cost < b->h_cost);
+}
+
+DEFINE_HEAP(bucket_heap, Node, 2, bucket_before)
+
+void init_buckets(BucketQueue* queue) {
+    /* Sets up an empty bucket queue. */
+
+    queue->num_buckets = INIT_BUCKETS;
+    queue->buckets = calloc(queue->num_buckets, sizeof *(queue->buckets));
+    queue->min_key = 0;
+    queue->max_key = 0;
+    queue->num_nodes = 0;
+}
+
+int push_bucket(BucketQueue* queue, Node* node) {
+    /* Adds a node to the bucket of its f_cost, widening the window of buckets first if the
+    f_cost falls outside of it. Returns the number of levels it rose in the bucket's heap. */
+
+    int key = node->f_cost;
+
+    if (queue->num_nodes == 0) {
+        // An empty queue can be moved anywhere.
+        queue->min_key = queue->max_key = key;
+    } else if (key < queue->min_key || key > queue->max_key) {
+        int min_key = (key < queue->min_key) ? key : queue->min_key;
+        int max_key = (key > queue->max_key) ? key : queue->max_key;
+        if (max_key - min_key >= queue->num_buckets) {
+            grow_buckets(queue, min_key, max_key);
+        }
+        queue->min_key = min_key;
+        queue->max_key = max_key;
+    }
+
+    Bucket* bucket = get_bucket(queue, key);
+    bucket->num_nodes++;
+    if (bucket->num_nodes > bucket->curr_size) {
+        bucket->curr_size = (bucket->curr_size) ? bucket->curr_size * 2 : INIT_BUCKET_SIZE;
+        bucket->nodes = realloc(bucket->nodes, bucket->curr_size * sizeof *(bucket->nodes));
+    }
+    queue->num_nodes++;
+    return bucket_heap_push(node, bucket->nodes, bucket->num_nodes);
+}
+
+Node* pop_bucket(BucketQueue* queue, int* num_levels) {
+    /* Removes and returns the node with the lowest f_cost (then lowest h_cost), saving the number
+    of levels sifted in its bucket's heap into num_levels (see heap.h). Returns NULL if the
+    queue is empty. */
+
+    if (queue->num_nodes == 0) {
+        return NULL;
+    }
+
+    // Skip past buckets that have been emptied since the last pop.
+    Bucket* bucket = get_bucket(queue, queue->min_key);
+    while (bucket->num_nodes == 0) {
+        bucket = get_bucket(queue, ++(queue->min_key));
+    }
+
+    queue->num_nodes--;
+    return bucket_heap_pop(bucket->nodes, (bucket->num_nodes)--, num_levels);
+}
+
+Node* peek_bucket(BucketQueue* queue) {
+    /* Returns the node with the lowest f_cost (then lowest h_cost) without removing it. Returns
+    NULL if the queue is empty. */
+
+    if (queue->num_nodes == 0) {
+        return NULL;
+    }
+
+    Bucket* bucket = get_bucket(queue, queue->min_key);
+    while (bucket->num_nodes == 0) {
+        bucket = get_bucket(queue, ++(queue->min_key));
+    }
+
+    return bucket->nodes[0];
+}
+
+int update_bucket(BucketQueue* queue, Node* node, int old_key) {
+    /* Moves a node already in the queue from the bucket of old_key to the bucket of its current
+    f_cost. Used when a shorter path to an open node is found. Returns the number of levels it
+    was moved within the buckets' heaps. */
+
+    Bucket* bucket = get_bucket(queue, old_key);
+    if (node->f_cost == old_key) {
+        // Only h_cost order within the bucket can have changed.
+        return bucket_heap_sift_up(bucket->nodes, node->heap_index);
+    }
+
+    int num_levels = bucket_heap_remove(bucket->nodes, (bucket->num_nodes)--, node->heap_index);
+    queue->num_nodes--;
+    return num_levels + push_bucket(queue, node);
+}
+
+Bucket* get_bucket(BucketQueue* queue, int key) {
+    // Returns the bucket that holds nodes with the given key.
+    return &queue->buckets[key & (queue->num_buckets - 1)];
+}
+
+void grow_buckets(BucketQueue* queue, int min_key, int max_key) {
+    /* Doubles the number of buckets until keys min_key to max_key fit in the window, moving every
+    bucket to its position in the new circular array. */
+
+    int old_num_buckets = queue->num_buckets;
+    Bucket* old_buckets = queue->buckets;
+
+    while (max_key - min_key >= queue->num_buckets) {
+        queue->num_buckets *= 2;
+    }
+    queue->buckets = calloc(queue->num_buckets, sizeof *(queue->buckets));
+
+    // Every key in the old window maps to a distinct bucket in the new one, so whole buckets can
+    // be moved across without touching their heaps.
+    for (int key = queue->min_key; key < queue->min_key + old_num_buckets; key++) {
+        *get_bucket(queue, key) = old_buckets[key & (old_num_buckets - 1)];
+    }
+
+    free(old_buckets);
+}
+
+void clear_buckets(BucketQueue* queue) {
+    // Empties the queue, keeping the memory of its buckets for the next search.
+    for (int i = 0; i < queue->num_buckets; i++) {
+        queue->buckets[i].num_nodes = 0;
+    }
+    queue->num_nodes = 0;
+}
+
+void free_buckets(BucketQueue* queue) {
+    for (int i = 0; i < queue->num_buckets; i++) {
+        free(queue->buckets[i].nodes);
+    }
+    free(queue->buckets);
+}
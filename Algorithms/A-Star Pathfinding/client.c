@@ -0,0 +1,426 @@
+// A client for the path-finding server (main --serve, see server.h and protocol.h): sends single
+// queries, reads the server's stats, and generates load to benchmark it.
+//
+// Usage:
+//   client SOCKET MAP START_ROW START_COL END_ROW END_COL
+//   client --stats [--reset] SOCKET
+//   client --load QUERY_FILE [--map M] [--connections C] [--depth D] [--queries N] [--path] SOCKET
+//
+// A single query prints the path's cost and its cells. END_ROW END_COL of -1 -1 asks for the
+// nearest of the map's ends. MAP is the index of the map, in the order the server was given them.
+//
+// --load sends the queries of a batch query file (see batch.h), over and over until N have been
+// sent (the number in the file by default), to map M (0 by default). Each of C connections (1 by
+// default) runs on its own thread and keeps D queries (1 by default) in flight at once, sending
+// another each time an answer comes back, so C * D is the load on the server. The latency of each
+// query is timed from just before it is sent to its answer being read, which counts the time it
+// waits behind others in flight. At the end it prints the throughput and latency percentiles, and
+// the server's own stats for the run (cleared before it starts). --path asks for every path too.
+//
+// Build with: gcc -std=c11 -Wall -O2 -pthread -o client client.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "protocol.h"
+#include "histogram.h"
+
+#define INIT_QUERIES 1024
+#define MAX_PAYLOAD (1 << 30)
+
+// What every connection of a load run shares.
+typedef struct {
+    char* socket_path;
+    ServerRequest* requests;
+    int num_requests;     // The distinct requests, from the query file.
+    int num_queries;      // The number of queries to send, over all of the connections.
+    int depth;
+    int flags;
+    int num_connections;
+    Histogram latencies;
+    atomic_int num_failed; // Connections that failed before sending all of their queries.
+    atomic_int num_no_path;
+    atomic_int num_bad;
+} Load;
+
+typedef struct {
+    Load* load;
+    int connection;
+} LoadThread;
+
+// Function declarations --------------------------------------------------------------------------
+
+int connect_server(char* socket_path);
+int send_request(int fd, ServerRequest* request);
+int read_response(int fd, ServerResponse* response, char** payload, uint32_t* payload_size);
+int run_query(char* socket_path, char** args);
+int run_stats(char* socket_path, int reset);
+int fetch_stats(char* socket_path, int reset, char** text);
+int run_load(char* socket_path, char* query_file, int map, int num_connections, int depth,
+    int num_queries, int flags);
+int load_requests(char* query_file, int map, ServerRequest** requests);
+void* load_connection(void* arg);
+void init_request(ServerRequest* request, uint32_t type, uint32_t flags);
+double get_time();
+
+// Function declarations end ----------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+
+    char* query_file = NULL;
+    int stats = 0, reset = 0, map = 0, num_connections = 1, depth = 1, num_queries = 0;
+    int flags = 0;
+    char* args[7];
+    int num_args = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            query_file = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "--reset") == 0) {
+            reset = 1;
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            map = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            num_connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            num_queries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--path") == 0) {
+            flags |= SERVER_WANT_PATH;
+        } else if (num_args < 7) {
+            args[num_args++] = argv[i];
+        } else {
+            num_args++;
+        }
+    }
+
+    if (query_file != NULL && num_args == 1) {
+        if (num_connections <= 0 || depth <= 0 || num_queries < 0 || map < 0) {
+            printf("--connections and --depth must be positive. Exiting...\n");
+            return 1;
+        }
+        return run_load(args[0], query_file, map, num_connections, depth, num_queries, flags);
+    } else if (stats && num_args == 1) {
+        return run_stats(args[0], reset);
+    } else if (query_file == NULL && !stats && num_args == 6) {
+        return run_query(args[0], args + 1);
+    }
+
+    printf("Usage: client SOCKET MAP START_ROW START_COL END_ROW END_COL\n"
+        "       client --stats [--reset] SOCKET\n"
+        "       client --load QUERY_FILE [--map M] [--connections C] [--depth D] [--queries N] "
+        "[--path] SOCKET\n");
+    return 1;
+}
+
+int connect_server(char* socket_path) {
+    // Connects to the server's socket. Returns the connection's file descriptor, or -1.
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof address.sun_path) {
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd != -1 && connect(fd, (struct sockaddr*) &address, sizeof address) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int send_request(int fd, ServerRequest* request) {
+    request->length = sizeof *(request) - sizeof request->length;
+    return write_full(fd, request, sizeof *(request));
+}
+
+int read_response(int fd, ServerResponse* response, char** payload, uint32_t* payload_size) {
+    /* Reads a response and its payload into *payload, which is grown to fit it (*payload_size is
+    its size). Returns the size of the payload, or -1 if the connection fails. */
+
+    if (read_full(fd, response, sizeof response->length) == -1 ||
+        response->length < sizeof *(response) - sizeof response->length ||
+        response->length > MAX_PAYLOAD ||
+        read_full(fd, &response->type, sizeof *(response) - sizeof response->length) == -1) {
+        return -1;
+    }
+
+    uint32_t size = response->length - (sizeof *(response) - sizeof response->length);
+    if (size + 1 > *payload_size) {
+        *payload_size = size + 1;
+        *payload = realloc(*payload, *payload_size);
+    }
+    if (read_full(fd, *payload, size) == -1) {
+        return -1;
+    }
+    (*payload)[size] = '\0';
+    return (int) size;
+}
+
+int run_query(char* socket_path, char** args) {
+    // Sends a single query and prints its answer.
+
+    int fd = connect_server(socket_path);
+    if (fd == -1) {
+        printf("Could not connect to '%s'. Exiting...\n", socket_path);
+        return 1;
+    }
+
+    ServerRequest request;
+    init_request(&request, SERVER_QUERY, SERVER_WANT_PATH);
+    request.map = atoi(args[0]);
+    request.start_row = atoi(args[1]);
+    request.start_col = atoi(args[2]);
+    request.end_row = atoi(args[3]);
+    request.end_col = atoi(args[4]);
+
+    ServerResponse response;
+    char* payload = NULL;
+    uint32_t payload_size = 0;
+    int size;
+    if (send_request(fd, &request) == -1 ||
+        (size = read_response(fd, &response, &payload, &payload_size)) == -1) {
+        printf("The server closed the connection. Exiting...\n");
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    if (response.status == SERVER_BAD_REQUEST) {
+        printf("No such map, or a cell outside of it.\n");
+    } else if (response.status == SERVER_NO_PATH) {
+        printf("No path found!\n");
+    } else {
+        int32_t* cells = (int32_t*) payload;
+        printf("Path cost: %d | Nodes expanded: %u | Cells: %d\n", response.path_cost,
+            response.num_expanded, size / (int) (2 * sizeof *(cells)));
+        for (int i = 0; i < size / (int) (2 * sizeof *(cells)); i++) {
+            printf("%d %d\n", cells[2 * i], cells[2 * i + 1]);
+        }
+    }
+    free(payload);
+    return 0;
+}
+
+int run_stats(char* socket_path, int reset) {
+    // Prints the server's stats, clearing them afterwards if reset is set.
+
+    char* text = NULL;
+    if (fetch_stats(socket_path, reset, &text) == -1) {
+        printf("Could not get the stats of the server on '%s'. Exiting...\n", socket_path);
+        return 1;
+    }
+    printf("%s", text);
+    free(text);
+    return 0;
+}
+
+int fetch_stats(char* socket_path, int reset, char** text) {
+    /* Asks the server for its stats, saving their JSON text into a newly allocated *text.
+    Returns 0, or -1 if the server can't be reached. */
+
+    int fd = connect_server(socket_path);
+    if (fd == -1) {
+        return -1;
+    }
+
+    ServerRequest request;
+    init_request(&request, SERVER_STATS, reset ? SERVER_RESET_STATS : 0);
+    ServerResponse response;
+    uint32_t text_size = 0;
+    *text = NULL;
+    int result = (send_request(fd, &request) == -1 ||
+        read_response(fd, &response, text, &text_size) == -1) ? -1 : 0;
+    close(fd);
+    return result;
+}
+
+int run_load(char* socket_path, char* query_file, int map, int num_connections, int depth,
+    int num_queries, int flags) {
+    /* Sends num_queries queries (or as many as the file has if 0) over num_connections
+    connections, depth at a time on each, then prints the throughput and latencies. */
+
+    Load load;
+    load.socket_path = socket_path;
+    load.num_requests = load_requests(query_file, map, &load.requests);
+    if (load.num_requests <= 0) {
+        printf("Could not read queries from '%s'. Exiting...\n", query_file);
+        return 1;
+    }
+    load.num_queries = num_queries ? num_queries : load.num_requests;
+    load.depth = depth;
+    load.flags = flags;
+    load.num_connections = num_connections;
+    clear_histogram(&load.latencies);
+    atomic_init(&load.num_failed, 0);
+    atomic_init(&load.num_no_path, 0);
+    atomic_init(&load.num_bad, 0);
+
+    // Start the server's stats afresh, so they only cover this run.
+    char* text = NULL;
+    if (fetch_stats(socket_path, 1, &text) == -1) {
+        printf("Could not connect to '%s'. Exiting...\n", socket_path);
+        return 1;
+    }
+    free(text);
+
+    double start_time = get_time();
+
+    pthread_t* threads = malloc(num_connections * sizeof *(threads));
+    LoadThread* args = malloc(num_connections * sizeof *(args));
+    for (int i = 0; i < num_connections; i++) {
+        args[i].load = &load;
+        args[i].connection = i;
+        pthread_create(&threads[i], NULL, load_connection, &args[i]);
+    }
+    for (int i = 0; i < num_connections; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = get_time() - start_time;
+    Histogram* latencies = &load.latencies;
+    uint64_t num_answered = atomic_load(&latencies->num_values);
+    printf("# Answered %" PRIu64 " queries in %.3f s on %d connections, %d in flight each "
+        "(%.1f queries/s), %d without a path, %d bad\n", num_answered, seconds, num_connections,
+        depth, num_answered / seconds, atomic_load(&load.num_no_path),
+        atomic_load(&load.num_bad));
+    printf("# Latency (us): mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+        num_answered ? atomic_load(&latencies->sum) / 1e3 / num_answered : 0.0,
+        get_percentile(latencies, 50) / 1e3, get_percentile(latencies, 90) / 1e3,
+        get_percentile(latencies, 99) / 1e3, get_percentile(latencies, 99.9) / 1e3,
+        atomic_load(&latencies->max) / 1e3);
+    if (atomic_load(&load.num_failed)) {
+        printf("# %d connections failed before sending all of their queries\n",
+            atomic_load(&load.num_failed));
+    }
+    if (fetch_stats(socket_path, 0, &text) == 0) {
+        printf("# Server: %s", text);
+        free(text);
+    }
+
+    free(threads);
+    free(args);
+    free(load.requests);
+    return atomic_load(&load.num_failed) ? 1 : 0;
+}
+
+int load_requests(char* query_file, int map, ServerRequest** requests) {
+    /* Reads every query of a batch query file into a newly allocated array of requests to a map.
+    Returns the number of queries, or -1 if the file can't be read. Cells aren't checked here, as
+    only the server knows the size of its maps. */
+
+    FILE* fp = fopen(query_file, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    int curr_size = INIT_QUERIES, num_requests = 0;
+    *requests = malloc(curr_size * sizeof **(requests));
+
+    int start_row, start_col, end_row, end_col;
+    while (fscanf(fp, "%d %d %d %d", &start_row, &start_col, &end_row, &end_col) == 4) {
+        if (num_requests == curr_size) {
+            curr_size *= 2;
+            *requests = realloc(*requests, curr_size * sizeof **(requests));
+        }
+
+        ServerRequest* request = &(*requests)[num_requests++];
+        init_request(request, SERVER_QUERY, 0);
+        request->map = map;
+        request->start_row = start_row;
+        request->start_col = start_col;
+        request->end_row = end_row;
+        request->end_col = end_col;
+    }
+
+    fclose(fp);
+    return num_requests;
+}
+
+void* load_connection(void* arg) {
+    /* Thread body of one connection of a load run. Sends its share of the queries, keeping up to
+    depth of them in flight, and times each one's answer. */
+
+    LoadThread* thread = arg;
+    Load* load = thread->load;
+
+    // Queries are shared out as evenly as possible, each connection starting at its own place in
+    // the file.
+    int num_queries = load->num_queries / load->num_connections +
+        (thread->connection < load->num_queries % load->num_connections);
+    int first = (int) ((int64_t) thread->connection * load->num_requests /
+        load->num_connections);
+    double* send_times = malloc(num_queries * sizeof *(send_times));
+
+    int fd = connect_server(load->socket_path);
+    if (fd == -1) {
+        atomic_fetch_add(&load->num_failed, 1);
+        free(send_times);
+        return NULL;
+    }
+
+    ServerResponse response;
+    char* payload = NULL;
+    uint32_t payload_size = 0;
+    int num_sent = 0, num_answered = 0;
+    while (num_answered < num_queries) {
+        while (num_sent < num_queries && num_sent - num_answered < load->depth) {
+            ServerRequest request = load->requests[(first + num_sent) % load->num_requests];
+            request.id = num_sent;
+            request.flags = load->flags;
+            send_times[num_sent] = get_time();
+            if (send_request(fd, &request) == -1) {
+                break;
+            }
+            num_sent++;
+        }
+
+        if (num_sent == num_answered ||
+            read_response(fd, &response, &payload, &payload_size) == -1 ||
+            response.id >= (uint32_t) num_sent) {
+            atomic_fetch_add(&load->num_failed, 1);
+            break;
+        }
+        add_to_histogram(&load->latencies,
+            (uint64_t) ((get_time() - send_times[response.id]) * 1e9));
+        if (response.status == SERVER_NO_PATH) {
+            atomic_fetch_add(&load->num_no_path, 1);
+        } else if (response.status == SERVER_BAD_REQUEST) {
+            atomic_fetch_add(&load->num_bad, 1);
+        }
+        num_answered++;
+    }
+
+    close(fd);
+    free(payload);
+    free(send_times);
+    return NULL;
+}
+
+void init_request(ServerRequest* request, uint32_t type, uint32_t flags) {
+    memset(request, 0, sizeof *(request));
+    request->type = type;
+    request->flags = flags;
+}
+
+double get_time() {
+    // Returns the time in seconds from a monotonic clock.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -0,0 +1,318 @@
+// Connected components of the open cells of a grid, so that a query between two cells that can't
+// reach each other is answered at once instead of after searching everything the start can reach.
+//
+// Every open cell holds the label of its component (obstacles hold 0). Labels are the elements of
+// a union-find structure, so two labels can name the same component: two cells are connected if
+// their labels have the same root. This is what lets labels be kept up to date cheaply as cells
+// change:
+//  - Opening a cell joins the components of its open neighbors, with one union per neighbor.
+//  - Closing a cell can only split its component if its open neighbors fall into several groups
+//    that don't touch each other around it. Each group but the first is then flooded with a new
+//    label until the flood either reaches the first group (so nothing was split, and the new
+//    label is joined to the old component) or runs out, in which case it has just labelled the
+//    part that was split off.
+//
+// Cells are connected the way searches move by default: to all 8 neighbors, cutting corners. The
+// other moves (see get_neighbors) can only connect fewer cells, so cells in different components
+// are never connected whichever moves a search uses.
+
+#define INIT_LABELS 64
+
+// Function declarations --------------------------------------------------------------------------
+
+void label_components(Grid* grid);
+uint32_t new_label(Components* components);
+uint32_t find_label(Components* components, uint32_t label);
+uint32_t compress_label(Components* components, uint32_t label);
+uint32_t union_labels(Components* components, uint32_t label1, uint32_t label2);
+int same_component(Grid* grid, uint32_t index1, uint32_t index2);
+void update_component(Grid* grid, uint32_t index);
+void close_component_cell(Grid* grid, uint32_t index);
+uint32_t flood_label(Grid* grid, uint32_t index, uint32_t old_root, uint32_t label,
+    uint32_t* stops, int num_stops);
+void free_components(Components* components);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void label_components(Grid* grid) {
+    /* Labels the components of the grid in two passes: the first gives each open cell the label of
+    an open neighbor above or to the left of it (or a new one) and joins the labels of the others,
+    and the second replaces each label with its root, numbered from 1. */
+
+    Components* components = &grid->components;
+    size_t num_cells = grid->num_cells;
+    components->labels = calloc(num_cells, sizeof *(components->labels));
+    components->curr_size = INIT_LABELS;
+    components->parents = malloc(components->curr_size * sizeof *(components->parents));
+    components->sizes = malloc(components->curr_size * sizeof *(components->sizes));
+    components->num_labels = 1; // Label 0 is for obstacles.
+
+    for (int row = 0; row < grid->num_rows; row++) {
+        for (int col = 0; col < grid->num_cols; col++) {
+            uint32_t index = get_index(grid, row, col);
+            if (is_obstacle(grid, index)) {
+                continue;
+            }
+
+            // The neighbors already labelled: left, and the three above.
+            uint32_t label = 0;
+            int neighbors[4][2] = { {row, col - 1}, {row - 1, col - 1}, {row - 1, col},
+                {row - 1, col + 1} };
+            for (int i = 0; i < 4; i++) {
+                int r = neighbors[i][0], c = neighbors[i][1];
+                if (r < 0 || c < 0 || c >= grid->num_cols) {
+                    continue;
+                }
+                uint32_t next_label = components->labels[get_index(grid, r, c)];
+                if (next_label) {
+                    label = (label) ? union_labels(components, label, next_label) : next_label;
+                }
+            }
+
+            components->labels[index] = (label) ? label : new_label(components);
+            components->sizes[compress_label(components, components->labels[index])]++;
+        }
+    }
+
+    // Number the roots from 1, reusing sizes to map each root to its number.
+    uint32_t num_labels = 1;
+    for (uint32_t label = 1; label < components->num_labels; label++) {
+        if (components->parents[label] == label) {
+            components->sizes[label] = num_labels++;
+        }
+    }
+    for (size_t i = 0; i < num_cells; i++) {
+        if (components->labels[i]) {
+            components->labels[i] = components->sizes[find_label(components,
+                components->labels[i])];
+        }
+    }
+
+    components->num_labels = num_labels;
+    for (uint32_t label = 1; label < num_labels; label++) {
+        components->parents[label] = label;
+        components->sizes[label] = 0;
+    }
+    for (size_t i = 0; i < num_cells; i++) {
+        components->sizes[components->labels[i]]++;
+    }
+}
+
+uint32_t new_label(Components* components) {
+    // Adds a new label, in a component of its own, and returns it.
+    if (components->num_labels == components->curr_size) {
+        components->curr_size *= 2;
+        components->parents = realloc(components->parents,
+            components->curr_size * sizeof *(components->parents));
+        components->sizes = realloc(components->sizes,
+            components->curr_size * sizeof *(components->sizes));
+    }
+    components->parents[components->num_labels] = components->num_labels;
+    components->sizes[components->num_labels] = 0;
+    return components->num_labels++;
+}
+
+uint32_t find_label(Components* components, uint32_t label) {
+    /* Returns the root of a label. Doesn't change anything, so searches on several threads can
+    call it at once. */
+    while (components->parents[label] != label) {
+        label = components->parents[label];
+    }
+    return label;
+}
+
+uint32_t compress_label(Components* components, uint32_t label) {
+    // Like find_label, but also points every label on the way straight at the root.
+    uint32_t root = find_label(components, label);
+    while (components->parents[label] != root) {
+        uint32_t parent = components->parents[label];
+        components->parents[label] = root;
+        label = parent;
+    }
+    return root;
+}
+
+uint32_t union_labels(Components* components, uint32_t label1, uint32_t label2) {
+    /* Joins the components of two labels, hanging the smaller one under the larger, and returns
+    the root of the result. */
+
+    uint32_t root1 = compress_label(components, label1);
+    uint32_t root2 = compress_label(components, label2);
+    if (root1 == root2) {
+        return root1;
+    }
+    if (components->sizes[root1] < components->sizes[root2]) {
+        uint32_t temp = root1;
+        root1 = root2;
+        root2 = temp;
+    }
+    components->parents[root2] = root1;
+    components->sizes[root1] += components->sizes[root2];
+    return root1;
+}
+
+int same_component(Grid* grid, uint32_t index1, uint32_t index2) {
+    // Returns whether there is a path between two cells. Obstacles have no path to anything.
+    Components* components = &grid->components;
+    uint32_t label1 = components->labels[index1], label2 = components->labels[index2];
+    return label1 && label2 && find_label(components, label1) == find_label(components, label2);
+}
+
+void update_component(Grid* grid, uint32_t index) {
+    /* Updates the labels after the type of a cell has been changed to its current one. */
+
+    Components* components = &grid->components;
+    int is_open = !is_obstacle(grid, index);
+    if (is_open == (components->labels[index] != 0)) {
+        return;
+    }
+
+    if (!is_open) {
+        close_component_cell(grid, index);
+        return;
+    }
+
+    // Join the components of every open neighbor.
+    int row = get_row(grid, index), col = get_col(grid, index);
+    uint32_t label = 0;
+    for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+            if (r < 0 || r >= grid->num_rows || c < 0 || c >= grid->num_cols) {
+                continue;
+            }
+            uint32_t next_label = components->labels[get_index(grid, r, c)];
+            if (next_label) {
+                label = (label) ? union_labels(components, label, next_label) : next_label;
+            }
+        }
+    }
+
+    if (!label) {
+        label = new_label(components);
+    }
+    components->labels[index] = label;
+    components->sizes[compress_label(components, label)]++;
+}
+
+void close_component_cell(Grid* grid, uint32_t index) {
+    /* Removes a newly closed cell from its component, and gives any part of the component that
+    it split off a label of its own. */
+
+    Components* components = &grid->components;
+    uint32_t old_root = compress_label(components, components->labels[index]);
+    components->labels[index] = 0;
+    components->sizes[old_root]--;
+
+    // Group the open cells around the closed one by whether they touch each other.
+    int row = get_row(grid, index), col = get_col(grid, index);
+    uint32_t ring[NUM_SURR];
+    int group[NUM_SURR];
+    int num_ring = 0;
+    for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+            if (r < 0 || r >= grid->num_rows || c < 0 || c >= grid->num_cols) {
+                continue;
+            }
+            uint32_t next_index = get_index(grid, r, c);
+            if (components->labels[next_index]) {
+                group[num_ring] = num_ring;
+                ring[num_ring++] = next_index;
+            }
+        }
+    }
+
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        for (int i = 0; i < num_ring; i++) {
+            for (int j = 0; j < num_ring; j++) {
+                if (group[j] < group[i] &&
+                    abs(get_row(grid, ring[i]) - get_row(grid, ring[j])) <= 1 &&
+                    abs(get_col(grid, ring[i]) - get_col(grid, ring[j])) <= 1) {
+                    group[i] = group[j];
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    // The first group keeps the old label. Flood each other group until it reaches the first.
+    uint32_t stops[NUM_SURR];
+    int num_stops = 0;
+    for (int i = 0; i < num_ring; i++) {
+        if (group[i] == group[0]) {
+            stops[num_stops++] = ring[i];
+        }
+    }
+
+    for (int i = 0; i < num_ring; i++) {
+        if (group[i] == group[0] || compress_label(components, components->labels[ring[i]]) !=
+            old_root) {
+            // Part of the first group, or already split off along with an earlier group.
+            continue;
+        }
+
+        uint32_t label = new_label(components);
+        uint32_t size = flood_label(grid, ring[i], old_root, label, stops, num_stops);
+        if (size) {
+            components->sizes[label] = size;
+            components->sizes[old_root] -= size;
+        } else {
+            components->parents[label] = old_root;
+        }
+    }
+}
+
+uint32_t flood_label(Grid* grid, uint32_t index, uint32_t old_root, uint32_t label,
+    uint32_t* stops, int num_stops) {
+    /* Gives label to the cells of the component of old_root reachable from index, until one of
+    the stops cells is reached. Returns the number of cells labelled if the flood ran out first
+    (they are a component of their own now), or 0 if a stop was reached. */
+
+    Components* components = &grid->components;
+    uint32_t curr_size = INIT_LABELS, num_queued = 0, size = 0;
+    uint32_t* queue = malloc(curr_size * sizeof *(queue));
+    queue[num_queued++] = index;
+    components->labels[index] = label;
+
+    while (size < num_queued) {
+        uint32_t curr_index = queue[size++];
+        int row = get_row(grid, curr_index), col = get_col(grid, curr_index);
+
+        for (int r = row - 1; r <= row + 1; r++) {
+            for (int c = col - 1; c <= col + 1; c++) {
+                if (r < 0 || r >= grid->num_rows || c < 0 || c >= grid->num_cols) {
+                    continue;
+                }
+                uint32_t next_index = get_index(grid, r, c);
+                uint32_t next_label = components->labels[next_index];
+                if (!next_label || next_label == label ||
+                    compress_label(components, next_label) != old_root) {
+                    continue;
+                }
+
+                for (int i = 0; i < num_stops; i++) {
+                    if (stops[i] == next_index) {
+                        free(queue);
+                        return 0;
+                    }
+                }
+
+                components->labels[next_index] = label;
+                if (num_queued == curr_size) {
+                    curr_size *= 2;
+                    queue = realloc(queue, curr_size * sizeof *(queue));
+                }
+                queue[num_queued++] = next_index;
+            }
+        }
+    }
+
+    free(queue);
+    return size;
+}
+
+void free_components(Components* components) {
+    free(components->labels);
+    free(components->parents);
+    free(components->sizes);
+}
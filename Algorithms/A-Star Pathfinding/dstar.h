@@ -0,0 +1,402 @@
+// Incremental replanning with D* Lite (Koenig and Likhachev, 2002) for maps whose cells open and
+// close while an agent is following its path.
+//
+// D* Lite searches backward, from the end towards the agent, and keeps its search tree between
+// plans. Every node has g (its distance to the end as of the last time it was expanded) and rhs
+// (the distance it should have going by its neighbors' g). Nodes where the two differ are
+// "inconsistent" and are the only ones on the open list. When cells change, only the rhs of the
+// changed cells and their neighbors is recomputed, and only nodes made inconsistent by that are
+// expanded again, in order of their keys, until the agent's own node is consistent again.
+//
+// Nodes use the fields of Node (heap.h) and share its heap: g_cost is g, f_cost is the first half
+// of the key (min(g, rhs) + h + k_m) and h_cost the second (min(g, rhs)), which is the order the
+// open list's cmp already sorts by. When the agent moves, k_m grows by the distance moved instead
+// of every key on the open list being recomputed, since each h then drops by at most that much.
+
+#include <limits.h>
+
+#define DSTAR_INFINITY (INT_MAX / 2) // Costs of unreachable nodes, small enough to add to.
+#define INIT_CHANGES 64
+#define MAX_LINE_LEN 64
+
+typedef struct {
+    Grid* grid;
+    Node* nodes;
+    int* rhs;
+    Node** open_nodes;
+    int num_open_nodes;
+    uint32_t start_index; // The agent.
+    uint32_t end_index;
+    int k_m;
+    int num_expanded;     // Nodes expanded since the last reset of the count.
+} DStar;
+
+// Function declarations --------------------------------------------------------------------------
+
+int run_replan(Grid* grid, int backend, char* change_file);
+void replan(DStar* dstar, Search* search, uint32_t* indices, char* types, int num_changes,
+    int batch);
+void init_dstar(DStar* dstar, Grid* grid, uint32_t start_index, uint32_t end_index);
+int plan_dstar(DStar* dstar);
+void move_dstar(DStar* dstar, uint32_t start_index);
+void change_cells(DStar* dstar, uint32_t* indices, char* types, int num_changes);
+void update_vertex(DStar* dstar, uint32_t index);
+void queue_vertex(DStar* dstar, uint32_t index);
+int get_rhs(DStar* dstar, uint32_t index);
+void set_key(DStar* dstar, Node* node, uint32_t index);
+uint32_t next_dstar_step(DStar* dstar, uint32_t index);
+int cmp_keys(int f_cost1, int h_cost1, int f_cost2, int h_cost2);
+void free_dstar(DStar* dstar);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int run_replan(Grid* grid, int backend, char* change_file) {
+    /* Plans a path from the map's start to its end with D* Lite, then replans after each batch of
+    changes in change_file. Each line of the file either changes a cell ("row col type", where
+    type is '_' or 'Z') or moves the agent ("S row col"), and a blank line ends a batch. For the
+    first plan and each replan, prints the path cost and the nodes expanded and time taken, next
+    to those of a fresh A* search over the changed map. Finally draws the last path found. */
+
+    if (grid->start_index == NO_INDEX || grid->end_index == NO_INDEX) {
+        printf("The map needs a start and an end to find a path between. Exiting...\n");
+        return 0;
+    }
+
+    FILE* fp = fopen(change_file, "r");
+    if (fp == NULL) {
+        printf("Could not read changes from '%s'. Exiting...\n", change_file);
+        return 0;
+    }
+
+    DStar dstar;
+    init_dstar(&dstar, grid, grid->start_index, grid->end_index);
+    Search search;
+    init_search(&search, grid, NULL, backend);
+
+    int curr_size = INIT_CHANGES, num_changes = 0, num_batches = 0;
+    uint32_t* indices = malloc(curr_size * sizeof *(indices));
+    char* types = malloc(curr_size * sizeof *(types));
+
+    printf("# batch changes path_cost replan_expanded replan_ms astar_cost astar_expanded "
+        "astar_ms\n");
+    replan(&dstar, &search, indices, types, 0, num_batches++);
+
+    char line[MAX_LINE_LEN];
+    int done = 0;
+    while (!done) {
+        int row, col;
+        char type;
+        done = (fgets(line, sizeof line, fp) == NULL);
+
+        if (!done && sscanf(line, " S %d %d", &row, &col) == 2) {
+            if (row < 0 || row >= grid->num_rows || col < 0 || col >= grid->num_cols) {
+                printf("Agent moved off the map: '%s'. Exiting...\n", line);
+                break;
+            }
+            move_dstar(&dstar, get_index(grid, row, col));
+            continue;
+        }
+
+        if (!done && sscanf(line, "%d %d %c", &row, &col, &type) == 3) {
+            if (row < 0 || row >= grid->num_rows || col < 0 || col >= grid->num_cols ||
+                (type != EMPTY && type != OBSTACLE)) {
+                printf("Invalid change: '%s'. Exiting...\n", line);
+                break;
+            }
+            if (num_changes == curr_size) {
+                curr_size *= 2;
+                indices = realloc(indices, curr_size * sizeof *(indices));
+                types = realloc(types, curr_size * sizeof *(types));
+            }
+            indices[num_changes] = get_index(grid, row, col);
+            types[num_changes++] = type;
+            continue;
+        }
+
+        // A blank line or the end of the file ends the batch.
+        if (num_changes) {
+            replan(&dstar, &search, indices, types, num_changes, num_batches++);
+            num_changes = 0;
+        }
+    }
+
+    // Draw the last path found, following each node's cheapest step towards the end.
+    if (same_component(grid, dstar.start_index, dstar.end_index)) {
+        reset_search(&search, dstar.start_index, dstar.end_index);
+        for (uint32_t index = dstar.start_index; index != dstar.end_index; ) {
+            uint32_t next_index = next_dstar_step(&dstar, index);
+            get_node(&search, next_index)->prev_index = index;
+            index = next_index;
+        }
+        draw_path(&search);
+        printf("Path cost: %d\n", dstar.rhs[dstar.start_index]);
+    } else {
+        print_grid(&search);
+        printf("No path found!\n");
+    }
+
+    fclose(fp);
+    free(indices);
+    free(types);
+    free_search(&search);
+    free_dstar(&dstar);
+    return 0;
+}
+
+void replan(DStar* dstar, Search* search, uint32_t* indices, char* types, int num_changes,
+    int batch) {
+    /* Applies a batch of changes and repairs the path with D* Lite, then finds the path again from
+    scratch with A* to compare, and prints both. */
+
+    double start_time = get_time();
+    dstar->num_expanded = 0;
+    change_cells(dstar, indices, types, num_changes);
+    int path_cost = plan_dstar(dstar);
+    double replan_time = get_time() - start_time;
+
+    start_time = get_time();
+    reset_search(search, dstar->start_index, dstar->end_index);
+    int astar_cost = find_path(search);
+    double astar_time = get_time() - start_time;
+
+    printf("%d %d %d %d %.3f %d %d %.3f\n", batch, num_changes, path_cost, dstar->num_expanded,
+        replan_time * 1000, astar_cost, search->num_expanded, astar_time * 1000);
+}
+
+void init_dstar(DStar* dstar, Grid* grid, uint32_t start_index, uint32_t end_index) {
+    /* Sets up a D* Lite search for a path from start_index to end_index over grid. The grid's
+    cells are changed with change_cells, so it must not be shared with other searches meanwhile. */
+
+    size_t num_cells = grid->num_cells;
+
+    dstar->grid = grid;
+    dstar->nodes = malloc(num_cells * sizeof *(dstar->nodes));
+    dstar->rhs = malloc(num_cells * sizeof *(dstar->rhs));
+    dstar->open_nodes = malloc(num_cells * sizeof *(dstar->open_nodes));
+    dstar->num_open_nodes = 0;
+    dstar->start_index = start_index;
+    dstar->end_index = end_index;
+    dstar->k_m = 0;
+    dstar->num_expanded = 0;
+
+    for (size_t i = 0; i < num_cells; i++) {
+        dstar->nodes[i].g_cost = DSTAR_INFINITY;
+        dstar->nodes[i].heap_index = -1;
+        dstar->rhs[i] = DSTAR_INFINITY;
+    }
+
+    // The end is the only inconsistent node to begin with.
+    dstar->rhs[end_index] = 0;
+    update_vertex(dstar, end_index);
+}
+
+int plan_dstar(DStar* dstar) {
+    /* Expands inconsistent nodes until the agent's node is consistent and no node left on the open
+    list could still change its distance. Returns the length of the shortest path from the agent
+    to the end, or -1 if there is none. */
+
+    Node* start = &dstar->nodes[dstar->start_index];
+
+    // With no path, planning would only expand the whole of the end's component. The open list
+    // is kept, so a later plan carries on from where this one would have started.
+    if (!same_component(dstar->grid, dstar->start_index, dstar->end_index)) {
+        return -1;
+    }
+
+    while (dstar->num_open_nodes) {
+        Node* node = dstar->open_nodes[0];
+        uint32_t index = node - dstar->nodes;
+
+        // Stop once the agent's key is no larger than any key left and the agent is consistent.
+        int start_min = num_min(start->g_cost, dstar->rhs[dstar->start_index]);
+        int start_f = (start_min >= DSTAR_INFINITY) ? DSTAR_INFINITY : start_min + dstar->k_m;
+        if (!cmp_keys(node->f_cost, node->h_cost, start_f, start_min) &&
+            dstar->rhs[dstar->start_index] == start->g_cost) {
+            break;
+        }
+
+        // The agent has moved since this key was set, so it may be too small. Put it back with
+        // its current key first.
+        int old_f_cost = node->f_cost, old_h_cost = node->h_cost;
+        set_key(dstar, node, index);
+        if (cmp_keys(old_f_cost, old_h_cost, node->f_cost, node->h_cost)) {
+            node_heap_sift_down(dstar->open_nodes, dstar->num_open_nodes, 0);
+            continue;
+        }
+
+        node_heap_pop(dstar->open_nodes, (dstar->num_open_nodes)--, NULL);
+        dstar->num_expanded++;
+
+        Grid* grid = dstar->grid;
+        int row = get_row(grid, index), col = get_col(grid, index);
+        int old_g_cost = node->g_cost;
+        if (node->g_cost > dstar->rhs[index]) {
+            // Overconsistent: the node got shorter, which can only make its neighbors shorter.
+            node->g_cost = dstar->rhs[index];
+        } else {
+            // Underconsistent: the node got longer, so the node itself and its neighbors whose rhs
+            // went through it need their rhs recomputed.
+            node->g_cost = DSTAR_INFINITY;
+            update_vertex(dstar, index);
+        }
+
+        for (int r = row - 1; r <= row + 1; r++) {
+            for (int c = col - 1; c <= col + 1; c++) {
+                uint32_t next_index = get_index(grid, r, c);
+                if ((r == row && c == col) || r < 0 || r >= grid->num_rows || c < 0 ||
+                    c >= grid->num_cols || next_index == dstar->end_index ||
+                    is_obstacle(grid, next_index)) {
+                    continue;
+                }
+
+                int step_cost = get_step_cost(grid, next_index, index);
+                if (node->g_cost < old_g_cost) {
+                    if (step_cost + node->g_cost < dstar->rhs[next_index]) {
+                        dstar->rhs[next_index] = step_cost + node->g_cost;
+                        queue_vertex(dstar, next_index);
+                    }
+                } else if (dstar->rhs[next_index] == step_cost + old_g_cost) {
+                    update_vertex(dstar, next_index);
+                }
+            }
+        }
+    }
+
+    return (dstar->rhs[dstar->start_index] >= DSTAR_INFINITY) ? -1
+                                                              : dstar->rhs[dstar->start_index];
+}
+
+void move_dstar(DStar* dstar, uint32_t start_index) {
+    /* Moves the agent to start_index. Every h_cost drops by at most the distance moved, which is
+    added to k_m instead of updating the keys already on the open list. */
+    dstar->k_m += get_min_distance(dstar->grid, dstar->start_index, start_index);
+    dstar->start_index = start_index;
+}
+
+void change_cells(DStar* dstar, uint32_t* indices, char* types, int num_changes) {
+    /* Sets the type of each cell in indices to the matching type in types (EMPTY or OBSTACLE),
+    and recomputes the rhs of the changed cells and their neighbors, since those are the only
+    nodes whose steps changed cost. Call plan_dstar afterwards to repair the path. */
+
+    Grid* grid = dstar->grid;
+    for (int i = 0; i < num_changes; i++) {
+        set_cell(grid, indices[i], types[i]);
+        update_component(grid, indices[i]);
+    }
+
+    for (int i = 0; i < num_changes; i++) {
+        int row = get_row(grid, indices[i]), col = get_col(grid, indices[i]);
+        for (int r = row - 1; r <= row + 1; r++) {
+            for (int c = col - 1; c <= col + 1; c++) {
+                if (r >= 0 && r < grid->num_rows && c >= 0 && c < grid->num_cols) {
+                    update_vertex(dstar, get_index(grid, r, c));
+                }
+            }
+        }
+    }
+}
+
+void update_vertex(DStar* dstar, uint32_t index) {
+    // Recomputes the rhs of a node (the end's is always 0), then queues it by its new rhs.
+    if (index != dstar->end_index) {
+        dstar->rhs[index] = get_rhs(dstar, index);
+    }
+    queue_vertex(dstar, index);
+}
+
+void queue_vertex(DStar* dstar, uint32_t index) {
+    /* Puts a node on the open list with its current key if it is inconsistent, or takes it off if
+    it isn't. */
+
+    Node* node = &dstar->nodes[index];
+    if (node->g_cost == dstar->rhs[index]) {
+        if (node->heap_index != -1) {
+            node_heap_remove(dstar->open_nodes, (dstar->num_open_nodes)--, node->heap_index);
+        }
+        return;
+    }
+
+    set_key(dstar, node, index);
+    if (node->heap_index == -1) {
+        node_heap_push(node, dstar->open_nodes, ++(dstar->num_open_nodes));
+    } else {
+        // The key can have moved either way.
+        node_heap_sift_up(dstar->open_nodes, node->heap_index);
+        node_heap_sift_down(dstar->open_nodes, dstar->num_open_nodes, node->heap_index);
+    }
+}
+
+int get_rhs(DStar* dstar, uint32_t index) {
+    // Returns the shortest distance to the end through any neighbor of a node, going by their g.
+
+    Grid* grid = dstar->grid;
+    int rhs = DSTAR_INFINITY;
+    if (is_obstacle(grid, index)) {
+        return rhs;
+    }
+
+    int row = get_row(grid, index), col = get_col(grid, index);
+    for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+            uint32_t next_index = get_index(grid, r, c);
+            if ((r == row && c == col) || r < 0 || r >= grid->num_rows || c < 0 ||
+                c >= grid->num_cols || is_obstacle(grid, next_index)) {
+                continue;
+            }
+
+            int cost = get_step_cost(grid, index, next_index) + dstar->nodes[next_index].g_cost;
+            if (cost < rhs) {
+                rhs = cost;
+            }
+        }
+    }
+
+    return rhs;
+}
+
+void set_key(DStar* dstar, Node* node, uint32_t index) {
+    // Sets the key of a node, kept in its f_cost and h_cost (see the top of this file).
+    int min_cost = num_min(node->g_cost, dstar->rhs[index]);
+    node->h_cost = min_cost;
+    node->f_cost = (min_cost >= DSTAR_INFINITY) ? DSTAR_INFINITY
+        : min_cost + get_min_distance(dstar->grid, dstar->start_index, index) + dstar->k_m;
+}
+
+uint32_t next_dstar_step(DStar* dstar, uint32_t index) {
+    /* Returns the neighbor of a node on its shortest path to the end: the one with the smallest
+    step cost plus g. Only valid after plan_dstar found a path through the node. */
+
+    Grid* grid = dstar->grid;
+    int row = get_row(grid, index), col = get_col(grid, index);
+    uint32_t best_index = index;
+    int best_cost = DSTAR_INFINITY;
+
+    for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+            uint32_t next_index = get_index(grid, r, c);
+            if ((r == row && c == col) || r < 0 || r >= grid->num_rows || c < 0 ||
+                c >= grid->num_cols || is_obstacle(grid, next_index)) {
+                continue;
+            }
+
+            int cost = get_step_cost(grid, index, next_index) + dstar->nodes[next_index].g_cost;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_index = next_index;
+            }
+        }
+    }
+
+    return best_index;
+}
+
+int cmp_keys(int f_cost1, int h_cost1, int f_cost2, int h_cost2) {
+    // Returns whether the first key comes before the second, in the order of node_before.
+    return (f_cost1 == f_cost2) ? (h_cost1 < h_cost2) : (f_cost1 < f_cost2);
+}
+
+void free_dstar(DStar* dstar) {
+    free(dstar->nodes);
+    free(dstar->rhs);
+    free(dstar->open_nodes);
+}
@@ -0,0 +1,374 @@
+// Flow fields: for many agents heading to the same end. One flood from the end finds the distance
+// from every cell to it, and every cell keeps the direction of its next step along a shortest
+// path, so any start's path is then followed step by step without searching. Steps cost the same
+// both ways (see get_step_cost), so the distances from the end are the distances to it.
+//
+// The flood runs on several threads in rounds, as a wavefront: each round, the threads share out
+// the cells of the frontier (those whose distance dropped since they were last expanded) and
+// expand those nearer to the end than the round's limit, lowering their neighbors' distances with
+// compare-and-swap and putting the neighbors they lower on the next frontier. The rest of the
+// frontier waits for a later round. Once no cell nearer than the limit is left, the limit moves
+// to FLOW_DELTA steps past the nearest waiting cell (delta-stepping; Meyer and Sanders, 2003), so
+// each round only expands a thin band of the wavefront, and few cells are expanded again because
+// a shorter path reached them after all: on a 2000x2000 terrain map, about as few as Dijkstra's
+// algorithm. The flood is over when the frontier is empty, and then no distance can drop any
+// further. Directions are only picked afterwards, from the final distances, so no thread ever
+// races another to set one.
+//
+// The field is saved to a file: a FlowHeader, the distance of every cell, and then the direction
+// of every cell. It is mapped into memory as is when loaded, like a landmark file (see alt.h).
+
+#if LAYOUT == LAYOUT_TILED
+    #define FLOW_MAGIC "FLW8" // In the order of cell indices, like landmark files (see alt.h).
+#else
+    #define FLOW_MAGIC "FLW1"
+#endif
+#define FLOW_UNREACHED UINT32_MAX // The distance of a cell the end can't reach.
+#define FLOW_NONE 255             // The direction of an obstacle, or of a cell the end can't reach.
+#define FLOW_END 4                // The direction of the end itself: no step.
+#define FLOW_DELTA 8              // The width of the band of the wavefront, in steps.
+#define FLOW_CHUNK 256            // The cells a thread takes from the frontier at once.
+
+typedef struct {
+    char magic[4];
+    int32_t num_rows;
+    int32_t num_cols;
+    uint32_t end_index;
+    int32_t moves;
+} FlowHeader;
+
+// A flow field loaded from a file. A cell's direction is (dy + 1) * 3 + (dx + 1), where dy and dx
+// are the row and column offsets of its next step.
+typedef struct {
+    uint32_t end_index;
+    uint32_t* distances;
+    uint8_t* directions;
+    void* file;
+    size_t file_size;
+} FlowField;
+
+// The state of a flood shared by its threads.
+typedef struct {
+    Grid* grid;
+    _Atomic uint32_t* distances;
+    _Atomic uint32_t* queued;     // The last round each cell was put on the next frontier in.
+    uint32_t* frontier;
+    uint32_t* next_frontier;
+    size_t num_frontier;
+    atomic_size_t num_next;
+    atomic_size_t next_chunk;
+    uint32_t round;
+    uint32_t limit;               // Only cells nearer than this are expanded.
+    uint32_t delta;
+    _Atomic uint32_t min_waiting; // The distance of the nearest cell on the next frontier.
+    uint8_t* directions;
+    pthread_barrier_t barrier;
+} Flood;
+
+// Function declarations --------------------------------------------------------------------------
+
+int make_flow_field(Grid* grid, int num_threads, char* file_name);
+void flood_flow_field(Flood* flood, int num_threads);
+void* flood_worker(void* arg);
+void queue_flood_cell(Flood* flood, uint32_t index, uint32_t* buffer, int* num_buffered);
+void flush_flood_cells(Flood* flood, uint32_t* buffer, int* num_buffered);
+void pick_directions(Flood* flood);
+int load_flow_field(FlowField* flow, Grid* grid, char* file_name);
+uint32_t get_flow_step(FlowField* flow, Grid* grid, uint32_t index);
+int follow_flow_field(FlowField* flow, Grid* grid, uint32_t start_index);
+void free_flow_field(FlowField* flow);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int make_flow_field(Grid* grid, int num_threads, char* file_name) {
+    /* Floods the grid from its end on num_threads threads (one per core if num_threads is 0) and
+    saves the flow field to file_name. Returns the number of threads used, or -1 on failure. */
+
+    if (grid->end_index == NO_INDEX || is_obstacle(grid, grid->end_index)) {
+        return -1;
+    }
+    if (num_threads <= 0) {
+        num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    size_t num_cells = grid->num_cells;
+    Flood flood;
+    flood.grid = grid;
+    flood.distances = malloc(num_cells * sizeof *(flood.distances));
+    flood.queued = calloc(num_cells, sizeof *(flood.queued));
+    flood.frontier = malloc(num_cells * sizeof *(flood.frontier));
+    flood.next_frontier = malloc(num_cells * sizeof *(flood.next_frontier));
+    flood.directions = malloc(num_cells);
+    flood_flow_field(&flood, num_threads);
+
+    FlowHeader header;
+    memcpy(header.magic, FLOW_MAGIC, sizeof header.magic);
+    header.num_rows = grid->num_rows;
+    header.num_cols = grid->num_cols;
+    header.end_index = grid->end_index;
+    header.moves = grid->moves;
+
+    FILE* fp = fopen(file_name, "wb");
+    int saved = (fp != NULL &&
+        fwrite(&header, sizeof header, 1, fp) == 1 &&
+        fwrite((uint32_t*) flood.distances, sizeof(uint32_t), num_cells, fp) == num_cells &&
+        fwrite(flood.directions, 1, num_cells, fp) == num_cells);
+    if (fp != NULL && fclose(fp) != 0) {
+        saved = 0;
+    }
+
+    free(flood.directions);
+    free(flood.next_frontier);
+    free(flood.frontier);
+    free((uint32_t*) flood.queued);
+    free((uint32_t*) flood.distances);
+    return saved ? num_threads : -1;
+}
+
+void flood_flow_field(Flood* flood, int num_threads) {
+    /* Finds the distance from the grid's end to every cell, and then each cell's direction, on
+    num_threads threads. */
+
+    Grid* grid = flood->grid;
+    size_t num_cells = grid->num_cells;
+    for (size_t i = 0; i < num_cells; i++) {
+        atomic_init(&flood->distances[i], FLOW_UNREACHED);
+    }
+
+    atomic_init(&flood->distances[grid->end_index], 0);
+    flood->frontier[0] = grid->end_index;
+    flood->num_frontier = 1;
+    atomic_init(&flood->num_next, 0);
+    atomic_init(&flood->next_chunk, 0);
+    atomic_init(&flood->min_waiting, FLOW_UNREACHED);
+    flood->round = 1;
+    flood->delta = FLOW_DELTA * PRECISION_MULT * grid->min_cost;
+    flood->limit = flood->delta;
+    pthread_barrier_init(&flood->barrier, NULL, num_threads);
+
+    pthread_t* threads = malloc(num_threads * sizeof *(threads));
+    for (int i = 0; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, flood_worker, flood);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    pthread_barrier_destroy(&flood->barrier);
+}
+
+void* flood_worker(void* arg) {
+    /* Thread body. Expands its share of each round's frontier, waiting for every other thread at
+    the end of each round, and then picks the directions of its share of the cells. */
+
+    Flood* flood = arg;
+    Grid* grid = flood->grid;
+    uint32_t buffer[FLOW_CHUNK];
+    int num_buffered = 0;
+
+    while (flood->num_frontier) {
+        size_t first;
+        while ( (first = atomic_fetch_add(&flood->next_chunk, FLOW_CHUNK)) <
+            flood->num_frontier ) {
+            size_t last = first + FLOW_CHUNK;
+            if (last > flood->num_frontier) {
+                last = flood->num_frontier;
+            }
+
+            for (size_t i = first; i < last; i++) {
+                uint32_t index = flood->frontier[i];
+                uint32_t distance = atomic_load_explicit(&flood->distances[index],
+                    memory_order_relaxed);
+                if (distance >= flood->limit) {
+                    queue_flood_cell(flood, index, buffer, &num_buffered); // Not yet.
+                    continue;
+                }
+
+                uint32_t neighbors[NUM_SURR];
+                int num_neighbors = get_open_neighbors(grid, index, neighbors);
+                for (int j = 0; j < num_neighbors; j++) {
+                    uint32_t next_index = neighbors[j];
+                    uint32_t next_distance = distance + get_step_cost(grid, index, next_index);
+                    uint32_t old_distance = atomic_load_explicit(&flood->distances[next_index],
+                        memory_order_relaxed);
+                    while (next_distance < old_distance) {
+                        if (atomic_compare_exchange_weak_explicit(&flood->distances[next_index],
+                            &old_distance, next_distance, memory_order_relaxed,
+                            memory_order_relaxed)) {
+                            queue_flood_cell(flood, next_index, buffer, &num_buffered);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        flush_flood_cells(flood, buffer, &num_buffered);
+
+        // One thread moves on to the next round while the others wait.
+        if (pthread_barrier_wait(&flood->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            uint32_t* frontier = flood->frontier;
+            flood->frontier = flood->next_frontier;
+            flood->next_frontier = frontier;
+            flood->num_frontier = atomic_load(&flood->num_next);
+            atomic_store(&flood->num_next, 0);
+            atomic_store(&flood->next_chunk, 0);
+
+            uint32_t min_waiting = atomic_exchange(&flood->min_waiting, FLOW_UNREACHED);
+            if (min_waiting != FLOW_UNREACHED && min_waiting >= flood->limit) {
+                flood->limit = min_waiting + flood->delta;
+            }
+            flood->round++;
+        }
+        pthread_barrier_wait(&flood->barrier);
+    }
+
+    pick_directions(flood);
+    return NULL;
+}
+
+void queue_flood_cell(Flood* flood, uint32_t index, uint32_t* buffer, int* num_buffered) {
+    // Puts a cell on the next frontier, unless it is on it already.
+
+    if (atomic_exchange_explicit(&flood->queued[index], flood->round, memory_order_relaxed) ==
+        flood->round) {
+        return;
+    }
+
+    buffer[(*num_buffered)++] = index;
+    if (*num_buffered == FLOW_CHUNK) {
+        flush_flood_cells(flood, buffer, num_buffered);
+    }
+}
+
+void flush_flood_cells(Flood* flood, uint32_t* buffer, int* num_buffered) {
+    /* Copies the cells a thread has gathered onto the next frontier, and lowers min_waiting to the
+    nearest of them. */
+
+    if (*num_buffered == 0) {
+        return;
+    }
+
+    size_t first = atomic_fetch_add(&flood->num_next, *num_buffered);
+    memcpy(&flood->next_frontier[first], buffer, *num_buffered * sizeof *(buffer));
+
+    uint32_t min_distance = FLOW_UNREACHED;
+    for (int i = 0; i < *num_buffered; i++) {
+        uint32_t distance = atomic_load_explicit(&flood->distances[buffer[i]],
+            memory_order_relaxed);
+        if (distance < min_distance) {
+            min_distance = distance;
+        }
+    }
+    uint32_t min_waiting = atomic_load(&flood->min_waiting);
+    while (min_distance < min_waiting &&
+        !atomic_compare_exchange_weak(&flood->min_waiting, &min_waiting, min_distance)) {
+    }
+
+    *num_buffered = 0;
+}
+
+void pick_directions(Flood* flood) {
+    /* Points each cell of the thread's share at its first neighbor (in row-major order) that a
+    shortest path to the end goes through. */
+
+    Grid* grid = flood->grid;
+    size_t num_cells = grid->num_cells;
+    size_t first;
+    while ( (first = atomic_fetch_add(&flood->next_chunk, FLOW_CHUNK)) < num_cells ) {
+        size_t last = (first + FLOW_CHUNK < num_cells) ? first + FLOW_CHUNK : num_cells;
+
+        for (size_t index = first; index < last; index++) {
+            uint32_t distance = atomic_load_explicit(&flood->distances[index],
+                memory_order_relaxed);
+            flood->directions[index] = FLOW_NONE;
+            if (distance == 0) {
+                flood->directions[index] = FLOW_END;
+            }
+            if (distance == 0 || distance == FLOW_UNREACHED) {
+                continue;
+            }
+
+            uint32_t neighbors[NUM_SURR];
+            int num_neighbors = get_open_neighbors(grid, index, neighbors);
+            for (int i = 0; i < num_neighbors; i++) {
+                uint32_t next_index = neighbors[i];
+                if (atomic_load_explicit(&flood->distances[next_index], memory_order_relaxed) +
+                    get_step_cost(grid, index, next_index) == distance) {
+                    int dy = get_row(grid, next_index) - get_row(grid, index);
+                    int dx = get_col(grid, next_index) - get_col(grid, index);
+                    flood->directions[index] = (dy + 1) * 3 + (dx + 1);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int load_flow_field(FlowField* flow, Grid* grid, char* file_name) {
+    /* Maps a flow field made by make_flow_field into memory. Returns 0, or -1 if the file can't
+    be read or wasn't made for a grid of this size and moves. */
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || (size_t) file_stat.st_size < sizeof(FlowHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    flow->file_size = file_stat.st_size;
+    flow->file = mmap(NULL, flow->file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (flow->file == MAP_FAILED) {
+        return -1;
+    }
+
+    FlowHeader* header = flow->file;
+    size_t num_cells = grid->num_cells;
+    if (memcmp(header->magic, FLOW_MAGIC, sizeof header->magic) != 0 ||
+        header->num_rows != grid->num_rows || header->num_cols != grid->num_cols ||
+        header->moves != grid->moves || header->end_index >= num_cells ||
+        flow->file_size != sizeof *(header) + num_cells * (sizeof(uint32_t) + 1)) {
+        munmap(flow->file, flow->file_size);
+        return -1;
+    }
+
+    flow->end_index = header->end_index;
+    flow->distances = (uint32_t*) (header + 1);
+    flow->directions = (uint8_t*) (flow->distances + num_cells);
+    return 0;
+}
+
+uint32_t get_flow_step(FlowField* flow, Grid* grid, uint32_t index) {
+    // Returns the next cell on a shortest path from a cell to the end, or NO_INDEX if there's none.
+    int direction = flow->directions[index];
+    if (direction == FLOW_NONE || direction == FLOW_END) {
+        return NO_INDEX;
+    }
+    return step_index(grid, index, direction / 3 - 1, direction % 3 - 1);
+}
+
+int follow_flow_field(FlowField* flow, Grid* grid, uint32_t start_index) {
+    /* Follows the flow field from a cell to the end. Returns the cost of the path, or -1 if the
+    end can't be reached from the cell. */
+
+    if (flow->directions[start_index] == FLOW_NONE) {
+        return -1;
+    }
+
+    int path_cost = 0;
+    uint32_t index = start_index, next_index;
+    while ( (next_index = get_flow_step(flow, grid, index)) != NO_INDEX ) {
+        path_cost += get_step_cost(grid, index, next_index);
+        index = next_index;
+    }
+    return path_cost;
+}
+
+void free_flow_field(FlowField* flow) {
+    munmap(flow->file, flow->file_size);
+}
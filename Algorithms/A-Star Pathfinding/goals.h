@@ -0,0 +1,143 @@
+// Searching for the nearest of many ends, such as the closest of hundreds of exits, with a single
+// A* search rather than one per end.
+//
+// The search ends when the first end is taken off the open list, which is then the nearest one
+// reachable. For that to hold, a node's h_cost must be a lower bound on its distance to every end,
+// so it is the octile distance to the nearest end (the minimum of consistent heuristics is
+// consistent too). Looking through every end for each node reached would make each step cost as
+// much as the number of ends, so the ends are indexed in a k-d tree: the list of ends is sorted so
+// that the middle end of each range splits the rest of it by row (at even depths) or column (at
+// odd ones), which takes no memory besides the list itself. Finding the nearest end goes down the
+// side of each split the cell is on first, and only looks at the other side if the split line is
+// nearer than the nearest end found so far, which on maps with ends spread around visits a number
+// of ends proportional to the depth of the tree.
+//
+// Whether a cell is an end is a lookup in a bitmap of the ends, like the obstacle bitmap. Ends in
+// other components than the start are never reached, so a search that can't reach any end ends
+// before it starts (see reaches_goal).
+
+// Function declarations --------------------------------------------------------------------------
+
+void index_goals(Grid* grid);
+void sort_goals(GoalPoint* points, uint32_t len, int by_col);
+int cmp_goal_rows(const void* a, const void* b);
+int cmp_goal_cols(const void* a, const void* b);
+int is_goal(Goals* goals, uint32_t index);
+int reaches_goal(Grid* grid, uint32_t index);
+int get_goal_distance(Grid* grid, Goals* goals, uint32_t index);
+void find_nearest_goal(Grid* grid, GoalPoint* points, uint32_t len, int by_col, int row, int col,
+    int* best);
+int get_point_distance(Grid* grid, int dy, int dx);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void index_goals(Grid* grid) {
+    /* Sorts the ends of a grid with more than one into a k-d tree, and marks them in a bitmap.
+    Grids with one end (or none) are left as they are. */
+
+    Goals* goals = &grid->goals;
+    if (goals->num_goals <= 1) {
+        return;
+    }
+
+    sort_goals(goals->points, goals->num_goals, 0);
+    goals->bitmap = calloc(get_bitmap_words(grid), sizeof *(goals->bitmap));
+    for (uint32_t i = 0; i < goals->num_goals; i++) {
+        uint32_t index = get_index(grid, goals->points[i].row, goals->points[i].col);
+        goals->bitmap[index / 64] |= 1ULL << (index % 64);
+    }
+}
+
+void sort_goals(GoalPoint* points, uint32_t len, int by_col) {
+    /* Orders a range of ends as a k-d tree: its middle end splits it by row (or by column if
+    by_col is set), and each half is split by the other the same way. */
+
+    if (len <= 1) {
+        return;
+    }
+
+    qsort(points, len, sizeof *(points), by_col ? cmp_goal_cols : cmp_goal_rows);
+    uint32_t mid = len / 2;
+    sort_goals(points, mid, !by_col);
+    sort_goals(points + mid + 1, len - mid - 1, !by_col);
+}
+
+int cmp_goal_rows(const void* a, const void* b) {
+    const GoalPoint* point1 = a;
+    const GoalPoint* point2 = b;
+    return (point1->row > point2->row) - (point1->row < point2->row);
+}
+
+int cmp_goal_cols(const void* a, const void* b) {
+    const GoalPoint* point1 = a;
+    const GoalPoint* point2 = b;
+    return (point1->col > point2->col) - (point1->col < point2->col);
+}
+
+int is_goal(Goals* goals, uint32_t index) {
+    return (goals->bitmap[index / 64] >> (index % 64)) & 1;
+}
+
+int reaches_goal(Grid* grid, uint32_t index) {
+    // Returns whether any of the grid's ends is in the same component as a cell.
+    Goals* goals = &grid->goals;
+    for (uint32_t i = 0; i < goals->num_goals; i++) {
+        GoalPoint* point = &goals->points[i];
+        if (same_component(grid, index, get_index(grid, point->row, point->col))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int get_goal_distance(Grid* grid, Goals* goals, uint32_t index) {
+    /* Returns the octile distance from a cell to the nearest of the ends, times the cheapest
+    terrain cost, which no path to any of them can cost less than. */
+    int best = INT32_MAX;
+    find_nearest_goal(grid, goals->points, goals->num_goals, 0, get_row(grid, index),
+        get_col(grid, index), &best);
+    return best * grid->min_cost;
+}
+
+void find_nearest_goal(Grid* grid, GoalPoint* points, uint32_t len, int by_col, int row, int col,
+    int* best) {
+    /* Lowers best to the distance from (row, col) to the nearest end in a range of the k-d tree
+    if that is nearer. The far side of the split is skipped unless the split line, which every end
+    on that side is at least as far as, is nearer than best. */
+
+    while (len > 0) {
+        uint32_t mid = len / 2;
+        GoalPoint* point = &points[mid];
+        int distance = get_point_distance(grid, point->row - row, point->col - col);
+        if (distance < *best) {
+            *best = distance;
+        }
+
+        // Ends before the middle one are on the lower side of the split, and ends after it on
+        // the higher side.
+        int split = by_col ? col - point->col : row - point->row;
+        GoalPoint* near = (split < 0) ? points : point + 1;
+        uint32_t near_len = (split < 0) ? mid : len - mid - 1;
+        GoalPoint* far = (split < 0) ? point + 1 : points;
+        uint32_t far_len = (split < 0) ? len - mid - 1 : mid;
+
+        // Check the near side first, to have the smallest best when deciding on the far one.
+        find_nearest_goal(grid, near, near_len, !by_col, row, col, best);
+        if (abs(split) * PRECISION_MULT >= *best) {
+            return;
+        }
+        points = far;
+        len = far_len;
+        by_col = !by_col;
+    }
+}
+
+int get_point_distance(Grid* grid, int dy, int dx) {
+    // Like get_distance, for two cells dy rows and dx columns apart.
+    dy = abs(dy);
+    dx = abs(dx);
+    if (grid->moves == MOVES_4) {
+        return (dx + dy) * PRECISION_MULT;
+    }
+    return num_min(dx, dy) * SQRT_2 + abs(dx - dy) * PRECISION_MULT;
+}
@@ -0,0 +1,408 @@
+// Hash-distributed A* (HDA*; Kishimoto, Fukunaga and Botea, 2009): one query searched by several
+// threads at once, for single paths over maps too big for one core.
+//
+// Every cell is owned by one thread, picked by hashing the HDA_BLOCK x HDA_BLOCK block of cells
+// it is in, so neighboring cells mostly share an owner and most new nodes stay with the thread
+// that made them. Each thread has its own open list (a Heap, see astar.h) and is the only one to
+// ever read or write the nodes of its cells. When a thread expands a node, each neighbor's g_cost
+// is sent to its owner, which keeps it if it is shorter than the one it has, and puts the node
+// (back) on its open list. Since threads expand nodes out of global f_cost order, a node can be
+// expanded before its shortest path is known, so closed nodes are reopened when a shorter path to
+// them arrives.
+//
+// Messages to other threads are gathered into batches of up to HDA_BATCH, which are pushed onto
+// the owner's inbox: a lock-free stack that any thread can push onto with a compare-and-swap, and
+// that the owner empties in one exchange. A batch is sent when it is full, every HDA_FLUSH
+// expansions, and before its thread goes idle.
+//
+// Optimality: the end's owner records its g_cost as the best cost found whenever it expands it.
+// Nodes with an f_cost of at least the best cost can't lead to a cheaper path, so a thread whose
+// open list holds no other nodes (or none at all) is idle. The search is over when every thread
+// is idle and no message is on its way, at which point every node that could have improved the
+// best cost has been expanded.
+//
+// Termination: num_busy counts the threads that aren't idle plus the messages sent but not yet
+// taken in by their owner. A sending thread is busy itself, and counts its messages before
+// pushing them; an idle thread that finds messages in its inbox marks itself busy before taking
+// them in, and takes them off the count only after that. So num_busy is never 0 while any work is
+// left, and can't rise again once it is 0, which every thread then sees and stops.
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+#define HDA_BLOCK 8  // The side of the blocks of cells hashed to the same thread.
+#define HDA_BATCH 64 // The most messages sent to another thread at once.
+#define HDA_FLUSH 32 // Expansions between sending batches that aren't full yet.
+
+// A shorter path to a node found by another thread: the node's g_cost when reached from prev_index.
+typedef struct {
+    uint32_t index;
+    uint32_t prev_index;
+    int g_cost;
+} HdaMessage;
+
+typedef struct hda_batch {
+    struct hda_batch* next; // The next batch in the same inbox.
+    int num_messages;
+    HdaMessage messages[HDA_BATCH];
+} HdaBatch;
+
+// What one thread owns. Aligned to a cache line so threads don't write to the same one.
+typedef struct {
+    _Alignas(64) _Atomic(HdaBatch*) inbox;
+    Heap open_nodes;
+    HdaBatch** outboxes;  // The batch being filled for each other thread, or NULL.
+    int id;
+    int num_expanded;
+    int num_reopened;
+    int num_decreased;
+    int64_t num_sent;     // Messages sent to other threads.
+    struct hda* hda;
+} HdaThread;
+
+// The state of an HDA* search. The nodes of every cell live in one array shared by all threads,
+// but each node is only ever touched by the thread that owns its cell.
+typedef struct hda {
+    Grid* grid;
+    Node* nodes;
+    uint32_t generation;
+    int num_threads;
+    HdaThread* threads;
+    uint32_t start_index;
+    uint32_t end_index;
+    atomic_int best_cost;  // The cheapest path found so far, or INT_MAX.
+    atomic_long num_busy;  // See the top of this file.
+} Hda;
+
+// Function declarations --------------------------------------------------------------------------
+
+void init_hda(Hda* hda, Grid* grid, int num_threads, int backend);
+int find_hda_path(Hda* hda, uint32_t start_index, uint32_t end_index);
+void* hda_worker(void* arg);
+void expand_hda_node(HdaThread* thread, Node* node);
+void send_hda_node(HdaThread* thread, uint32_t index, uint32_t prev_index, int g_cost);
+void flush_hda_batch(HdaThread* thread, int owner);
+int receive_hda_batches(HdaThread* thread);
+void reach_hda_node(HdaThread* thread, uint32_t index, uint32_t prev_index, int g_cost);
+Node* get_hda_node(Hda* hda, uint32_t index);
+int get_hda_owner(Hda* hda, uint32_t index);
+int is_hda_idle(HdaThread* thread);
+void get_hda_counts(Hda* hda, Counts* counts);
+void free_hda(Hda* hda);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void init_hda(Hda* hda, Grid* grid, int num_threads, int backend) {
+    /* Allocates the nodes of every cell, and the open list and outboxes of num_threads threads
+    (one per core if num_threads is 0). */
+
+    if (num_threads <= 0) {
+        num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    hda->grid = grid;
+    hda->nodes = calloc(grid->num_cells, sizeof *(hda->nodes));
+    hda->generation = 0;
+    hda->num_threads = num_threads;
+    hda->threads = aligned_alloc(64, num_threads * sizeof *(hda->threads));
+    for (int i = 0; i < num_threads; i++) {
+        HdaThread* thread = &hda->threads[i];
+        atomic_init(&thread->inbox, NULL);
+        init_open_nodes(&thread->open_nodes, backend);
+        thread->outboxes = calloc(num_threads, sizeof *(thread->outboxes));
+        thread->id = i;
+        thread->hda = hda;
+    }
+}
+
+int find_hda_path(Hda* hda, uint32_t start_index, uint32_t end_index) {
+    /* Searches for a path from start_index to end_index on all of the threads. Returns the cost
+    of the shortest path, or -1 if there is none. The path can be followed back from the end
+    through the prev_index of hda->nodes. */
+
+    hda->generation++;
+    if (hda->generation == 0) {
+        size_t num_cells = hda->grid->num_cells;
+        for (size_t i = 0; i < num_cells; i++) {
+            hda->nodes[i].generation = 0;
+        }
+        hda->generation = 1;
+    }
+
+    hda->start_index = start_index;
+    hda->end_index = end_index;
+    atomic_init(&hda->best_cost, INT_MAX);
+    atomic_init(&hda->num_busy, hda->num_threads);
+    for (int i = 0; i < hda->num_threads; i++) {
+        HdaThread* thread = &hda->threads[i];
+        clear_open_nodes(&thread->open_nodes);
+        thread->open_nodes.num_pushes = 0;
+        thread->open_nodes.num_pops = 0;
+        thread->open_nodes.num_sift_levels = 0;
+        thread->open_nodes.max_sift_depth = 0;
+        thread->open_nodes.peak_open_nodes = 0;
+        thread->num_expanded = 0;
+        thread->num_reopened = 0;
+        thread->num_decreased = 0;
+        thread->num_sent = 0;
+    }
+
+    if (!same_component(hda->grid, start_index, end_index)) {
+        return -1;
+    }
+
+    // The start goes straight onto its owner's open list, before any thread runs.
+    reach_hda_node(&hda->threads[get_hda_owner(hda, start_index)], start_index, start_index, 0);
+
+    pthread_t* threads = malloc(hda->num_threads * sizeof *(threads));
+    for (int i = 0; i < hda->num_threads; i++) {
+        pthread_create(&threads[i], NULL, hda_worker, &hda->threads[i]);
+    }
+    for (int i = 0; i < hda->num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    int best_cost = atomic_load(&hda->best_cost);
+    return (best_cost == INT_MAX) ? -1 : best_cost;
+}
+
+void* hda_worker(void* arg) {
+    /* Thread body. Expands the thread's best node while it has one that could still lead to a
+    cheaper path, taking in messages from other threads between expansions, and waits for more
+    messages (or the end of the search) when it has none. */
+
+    HdaThread* thread = arg;
+    Hda* hda = thread->hda;
+    int since_flush = 0;
+
+    while (1) {
+        receive_hda_batches(thread);
+
+        if (!is_hda_idle(thread)) {
+            expand_hda_node(thread, pop_open_node(&thread->open_nodes));
+            if (++since_flush == HDA_FLUSH) {
+                for (int i = 0; i < hda->num_threads; i++) {
+                    flush_hda_batch(thread, i);
+                }
+                since_flush = 0;
+            }
+            continue;
+        }
+
+        // Idle: send everything still held back, then stop counting as busy.
+        for (int i = 0; i < hda->num_threads; i++) {
+            flush_hda_batch(thread, i);
+        }
+        since_flush = 0;
+        atomic_fetch_sub(&hda->num_busy, 1);
+
+        while (atomic_load_explicit(&thread->inbox, memory_order_acquire) == NULL &&
+            atomic_load(&hda->num_busy) != 0) {
+            sched_yield();
+        }
+        if (atomic_load_explicit(&thread->inbox, memory_order_acquire) == NULL) {
+            break; // Nothing is busy and nothing is on its way: the search is over.
+        }
+        atomic_fetch_add(&hda->num_busy, 1);
+    }
+
+    return NULL;
+}
+
+void expand_hda_node(HdaThread* thread, Node* node) {
+    /* Closes a node and sends each of its neighbors, with the g_cost of reaching it through the
+    node, to the neighbor's owner. Expanding the end instead records a new best cost. */
+
+    Hda* hda = thread->hda;
+    Grid* grid = hda->grid;
+    uint32_t index = (uint32_t) (node - hda->nodes);
+    node->is_open = 0;
+    thread->num_expanded++;
+
+    if (index == hda->end_index) {
+        // The best cost only ever drops, whichever thread lowers it.
+        int best_cost = atomic_load(&hda->best_cost);
+        while (node->g_cost < best_cost &&
+            !atomic_compare_exchange_weak(&hda->best_cost, &best_cost, node->g_cost)) {
+        }
+        return;
+    }
+
+    uint32_t neighbors[NUM_SURR];
+    int num_neighbors = get_open_neighbors(grid, index, neighbors);
+    int best_cost = atomic_load_explicit(&hda->best_cost, memory_order_relaxed);
+
+    for (int i = 0; i < num_neighbors; i++) {
+        uint32_t next_index = neighbors[i];
+        int g_cost = node->g_cost + get_step_cost(grid, index, next_index);
+        if (next_index != node->prev_index &&
+            g_cost + get_min_distance(grid, next_index, hda->end_index) < best_cost) {
+            send_hda_node(thread, next_index, index, g_cost);
+        }
+    }
+}
+
+void send_hda_node(HdaThread* thread, uint32_t index, uint32_t prev_index, int g_cost) {
+    // Passes a path to a node on to the node's owner: at once if it's this thread.
+
+    Hda* hda = thread->hda;
+    int owner = get_hda_owner(hda, index);
+    if (owner == thread->id) {
+        reach_hda_node(thread, index, prev_index, g_cost);
+        return;
+    }
+
+    HdaBatch* batch = thread->outboxes[owner];
+    if (batch == NULL) {
+        batch = thread->outboxes[owner] = malloc(sizeof *(batch));
+        batch->num_messages = 0;
+    }
+    HdaMessage* message = &batch->messages[batch->num_messages++];
+    message->index = index;
+    message->prev_index = prev_index;
+    message->g_cost = g_cost;
+    thread->num_sent++;
+
+    if (batch->num_messages == HDA_BATCH) {
+        flush_hda_batch(thread, owner);
+    }
+}
+
+void flush_hda_batch(HdaThread* thread, int owner) {
+    /* Pushes the batch of messages held back for owner (if any) onto owner's inbox, counting its
+    messages as busy first (see the top of this file). */
+
+    HdaBatch* batch = thread->outboxes[owner];
+    if (batch == NULL) {
+        return;
+    }
+    thread->outboxes[owner] = NULL;
+
+    Hda* hda = thread->hda;
+    atomic_fetch_add(&hda->num_busy, batch->num_messages);
+
+    HdaThread* to = &hda->threads[owner];
+    batch->next = atomic_load_explicit(&to->inbox, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&to->inbox, &batch->next, batch,
+        memory_order_release, memory_order_relaxed)) {
+    }
+}
+
+int receive_hda_batches(HdaThread* thread) {
+    /* Takes every batch in the thread's inbox and applies their messages. Returns the number of
+    messages taken in. */
+
+    HdaBatch* batch = atomic_exchange_explicit(&thread->inbox, NULL, memory_order_acquire);
+    int num_messages = 0;
+
+    while (batch != NULL) {
+        for (int i = 0; i < batch->num_messages; i++) {
+            HdaMessage* message = &batch->messages[i];
+            reach_hda_node(thread, message->index, message->prev_index, message->g_cost);
+        }
+        num_messages += batch->num_messages;
+
+        HdaBatch* next = batch->next;
+        free(batch);
+        batch = next;
+    }
+
+    if (num_messages) {
+        atomic_fetch_sub(&thread->hda->num_busy, num_messages);
+    }
+    return num_messages;
+}
+
+void reach_hda_node(HdaThread* thread, uint32_t index, uint32_t prev_index, int g_cost) {
+    /* Applies a path to a node the thread owns: if it is shorter than the node's current one (or
+    the node is new), the node takes it and goes on the open list, or moves up in it. A closed
+    node is reopened. */
+
+    Hda* hda = thread->hda;
+    Node* node = get_hda_node(hda, index);
+
+    if (!node->analyzed_once) {
+        node->h_cost = get_min_distance(hda->grid, index, hda->end_index);
+    } else if (g_cost >= node->g_cost) {
+        return;
+    }
+
+    int old_f_cost = node->f_cost;
+    node->g_cost = g_cost;
+    node->f_cost = g_cost + node->h_cost;
+    node->prev_index = prev_index;
+
+    if (!node->analyzed_once) {
+        node->analyzed_once = 1;
+        add_open_node(node, &thread->open_nodes);
+    } else if (node->is_open) {
+        thread->num_decreased++;
+        update_open_node(node, old_f_cost, &thread->open_nodes);
+    } else {
+        node->is_open = 1;
+        thread->num_reopened++;
+        add_open_node(node, &thread->open_nodes);
+    }
+}
+
+Node* get_hda_node(Hda* hda, uint32_t index) {
+    // Like get_node (see main.c), for the nodes of an HDA* search.
+    Node* node = &hda->nodes[index];
+    if (node->generation != hda->generation) {
+        node->generation = hda->generation;
+        node->is_open = 1;
+        node->analyzed_once = 0;
+        node->heap_index = -1;
+    }
+    return node;
+}
+
+int get_hda_owner(Hda* hda, uint32_t index) {
+    // Returns the thread that owns a cell, by hashing the block of cells it is in.
+    Grid* grid = hda->grid;
+    uint32_t row = get_row(grid, index) / HDA_BLOCK, col = get_col(grid, index) / HDA_BLOCK;
+    uint32_t block = row * 0x9E3779B1u ^ col * 0x85EBCA77u;
+    block = (block ^ (block >> 15)) * 0x2C1B3C6Du;
+    return (int) (((uint64_t) (block ^ (block >> 12)) * hda->num_threads) >> 32);
+}
+
+int is_hda_idle(HdaThread* thread) {
+    // Returns whether the thread has no node left that could lead to a cheaper path.
+    Node* top = peek_open_node(&thread->open_nodes);
+    return top == NULL ||
+        top->f_cost >= atomic_load_explicit(&thread->hda->best_cost, memory_order_relaxed);
+}
+
+void get_hda_counts(Hda* hda, Counts* counts) {
+    // Saves the counts of the last search into counts, adding the peaks of the threads together.
+    memset(counts, 0, sizeof *(counts));
+    for (int i = 0; i < hda->num_threads; i++) {
+        HdaThread* thread = &hda->threads[i];
+        Heap* open_nodes = &thread->open_nodes;
+        counts->num_expanded += thread->num_expanded;
+        counts->num_reopened += thread->num_reopened;
+        counts->num_decreased += thread->num_decreased;
+        counts->num_pushes += open_nodes->num_pushes;
+        counts->num_pops += open_nodes->num_pops;
+        counts->num_sift_levels += open_nodes->num_sift_levels;
+        counts->peak_open_nodes += open_nodes->peak_open_nodes;
+        if (open_nodes->max_sift_depth > counts->max_sift_depth) {
+            counts->max_sift_depth = open_nodes->max_sift_depth;
+        }
+    }
+}
+
+void free_hda(Hda* hda) {
+    for (int i = 0; i < hda->num_threads; i++) {
+        HdaThread* thread = &hda->threads[i];
+        Heap* open_nodes = &thread->open_nodes;
+        free(open_nodes->nodes);
+        free_buckets(&open_nodes->buckets);
+        free(thread->outboxes);
+    }
+    free(hda->threads);
+    free(hda->nodes);
+}
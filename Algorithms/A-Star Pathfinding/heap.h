@@ -1,167 +1,150 @@
-#define DEBUG_H 0
-
-#define DATATYPE Node
-#define PROPERTY .f_cost
-
-#define MAKE_PROP(var) (var PROPERTY)
+// A generator of typed heaps of pointers, such as the open lists of the searches.
+//
+// DEFINE_HEAP(NAME, TYPE, ARITY, BEFORE) defines a heap of TYPE* in an array, where each item has
+// ARITY children (2, 4 or 8) and BEFORE(a, b) says whether item a must come out before item b.
+// TYPE must have an int heap_index field, which the heap keeps equal to the item's position in the
+// array (or -1 once it has been taken out), so that an item whose key changed can be found and
+// moved without searching for it. BEFORE is called directly rather than through a pointer, so it
+// can be a static inline function or a macro and is inlined into every comparison. It defines:
+//  - NAME_heapify(array, len): puts len items in any order into heap order.
+//  - NAME_push(item, array, len): adds item as the len-th item (len counts it), and sifts it up.
+//  - NAME_pop(array, len, num_levels): takes the root out of a heap of len items and returns it.
+//  - NAME_sift_up(array, index): moves an item up, after its key was lowered (decrease-key).
+//  - NAME_sift_down(array, len, index): moves an item down, after its key was raised.
+//  - NAME_remove(array, len, index): takes the item at index out of a heap of len items.
+// Each returns the number of levels an item moved, which the searches count (see count_sift in
+// main.c). Sifting moves the other items into the hole left by the one being sifted, and only
+// writes that one into its final place, instead of swapping it down (or up) one level at a time.
+//
+// Wider heaps are shallower (log base ARITY of the number of items), so a pop moves the last item
+// down fewer levels, but picks the smallest of more children at each one, which sit next to each
+// other in memory. Pushes and decrease-keys, the most frequent operations of a search, only ever
+// compare an item with its parent, so they get cheaper as the heap gets wider. The open lists of
+// the searches rarely hold more than tens of thousands of nodes, though, and on the benchmark maps
+// the binary heap was as fast as the 4-ary one and faster than the 8-ary one.
+
+// The children of each node of the open lists' heaps, fixed at build time by defining HEAP_ARITY
+// (e.g. -DHEAP_ARITY=4). Nodes with equal keys can come out in another order with other arities,
+// so searches may expand different nodes and return different paths of the same cost.
+#ifndef HEAP_ARITY
+    #define HEAP_ARITY 2
+#endif
+
+#define DEFINE_HEAP(NAME, TYPE, ARITY, BEFORE)                                                    \
+                                                                                                  \
+static inline int NAME##_sift_up(TYPE** array, int index) {                                       \
+    TYPE* item = array[index];                                                                    \
+    int num_levels = 0;                                                                           \
+    while (index > 0) {                                                                           \
+        int parent_index = (index - 1) / (ARITY);                                                 \
+        if (!BEFORE(item, array[parent_index])) {                                                 \
+            break;                                                                                \
+        }                                                                                         \
+        array[index] = array[parent_index];                                                       \
+        array[index]->heap_index = index;                                                         \
+        index = parent_index;                                                                     \
+        num_levels++;                                                                             \
+    }                                                                                             \
+    array[index] = item;                                                                          \
+    item->heap_index = index;                                                                     \
+    return num_levels;                                                                            \
+}                                                                                                 \
+                                                                                                  \
+static inline int NAME##_sift_down(TYPE** array, int len, int index) {                            \
+    TYPE* item = array[index];                                                                    \
+    int num_levels = 0;                                                                           \
+    while (index * (ARITY) + 1 < len) {                                                           \
+        /* Find the child to come out first. Later children win ties, which keeps the order   */  \
+        /* of the earlier binary heap, so searches expand the same nodes as before.            */  \
+        int first_index = index * (ARITY) + 1;                                                    \
+        int end_index = (len - first_index < (ARITY)) ? len : first_index + (ARITY);              \
+        int child_index = first_index;                                                            \
+        for (int i = first_index + 1; i < end_index; i++) {                                      \
+            if (!BEFORE(array[child_index], array[i])) {                                          \
+                child_index = i;                                                                  \
+            }                                                                                     \
+        }                                                                                         \
+        if (!BEFORE(array[child_index], item)) {                                                  \
+            break;                                                                                \
+        }                                                                                         \
+        array[index] = array[child_index];                                                        \
+        array[index]->heap_index = index;                                                         \
+        index = child_index;                                                                      \
+        num_levels++;                                                                             \
+    }                                                                                             \
+    array[index] = item;                                                                          \
+    item->heap_index = index;                                                                     \
+    return num_levels;                                                                            \
+}                                                                                                 \
+                                                                                                  \
+static inline void NAME##_heapify(TYPE** array, int len) {                                        \
+    /* Sift down every item with children, from the last one back to the root. */                 \
+    for (int i = (len - 2) / (ARITY); len > 1 && i >= 0; i--) {                                   \
+        NAME##_sift_down(array, len, i);                                                          \
+    }                                                                                             \
+}                                                                                                 \
+                                                                                                  \
+static inline int NAME##_push(TYPE* item, TYPE** array, int len) {                                \
+    array[len - 1] = item;                                                                        \
+    return NAME##_sift_up(array, len - 1);                                                        \
+}                                                                                                 \
+                                                                                                  \
+static inline TYPE* NAME##_pop(TYPE** array, int len, int* num_levels) {                          \
+    /* The last item takes the root's place and sinks to where it belongs. num_levels can be */   \
+    /* NULL.                                                                                  */  \
+    TYPE* root = array[0];                                                                        \
+    root->heap_index = -1;                                                                        \
+    int levels = 0;                                                                               \
+    if (--len > 0) {                                                                              \
+        array[0] = array[len];                                                                    \
+        levels = NAME##_sift_down(array, len, 0);                                                 \
+    }                                                                                             \
+    if (num_levels != NULL) {                                                                     \
+        *num_levels = levels;                                                                     \
+    }                                                                                             \
+    return root;                                                                                  \
+}                                                                                                 \
+                                                                                                  \
+static inline int NAME##_remove(TYPE** array, int len, int index) {                               \
+    /* The last item takes the removed one's place, and moves up or down from there. Only one */  \
+    /* of the two sifts can move it.                                                          */  \
+    TYPE* item = array[index];                                                                    \
+    item->heap_index = -1;                                                                        \
+    if (index == --len) {                                                                         \
+        return 0;                                                                                 \
+    }                                                                                             \
+    array[index] = array[len];                                                                    \
+    return NAME##_sift_up(array, index) + NAME##_sift_down(array, len, index);                    \
+}
 
+// The search ("hot") fields of a grid cell. Nodes live contiguously in one array indexed by cell
+// index (see get_index in map.h), so a node's position and its parent are both plain cell
+// indices. The map ("cold") fields of a cell are kept apart from them (see Grid in astar.h).
 typedef struct node {
-    char type;
-    int row;
-    int col;
-
     int g_cost; // Distance to start node.
     int h_cost; // Distance to end node.
     int f_cost; // Sum of g_cost and h_cost.
 
-    int is_open;
-    int analyzed_once;
-    int num_neighbors;
     int heap_index;
-    struct node* prev_node;
+    uint32_t prev_index; // Cell index of the node this one was reached from.
+    uint32_t generation; // The search these fields belong to (see get_node in main.c).
+    char is_open;
+    char analyzed_once;
 } Node;
 
 // Function declarations --------------------------------------------------------------------------
 
-void heapify(Node** array, int len, int (*cmp)(Node* a, Node* b));
-Node* pop_root(Node** arr, int len, int (*cmp)(Node* a, Node* b));
-void add_node ( Node* node, Node** array, int len, int (*cmp)(Node* a, Node* b) );
-int get_parent_index(int child_index);
-int get_first_child_index(int parent_index);
-void check_node( Node** array, int len, int index, int (*cmp)(Node* a, Node* b) );
-void swap_nodes(Node** num1, Node** num2);
-// int min(Node* a, Node* b);
-// int max(Node* a, Node* b);
+static inline int node_before(Node* a, Node* b);
 
 // Function declarations end ----------------------------------------------------------------------
 
-void heapify(Node** array, int len, int (*cmp)(Node* a, Node* b)) {
-    /* Turns any given array of integers into a heap structure following the rules given by the
-    given cmp function. */
-
-    // Get the index of the first parent node.
-    int first_parent_index = get_parent_index(len - 1);
-
-    // Check that each parent node is in the right position relative to its children.
-    // This guarentees a heap structure.
-    for (int i = first_parent_index; i >= 0; i--) {
-        check_node(array, len, i, cmp);
-    }
-}
-
-Node* pop_root(Node** arr, int len, int (*cmp)(Node* a, Node* b)) {
-    /* Removes the root of the binary tree and returns it. Reorganizes the array back into heap
-    form afterwards. */
-
-    // Save the root value and swap it with the last leaf. Then free the memory of the last leaf.
-    Node* root = arr[0];
-    if (DEBUG_H) printf("Pop ");
-    swap_nodes(&arr[0], &arr[--len]);
-
-    // Reorganize the array back into a correct heap structure and return the former root.
-    check_node(arr, len, 0, cmp);
-    return root;
-}
-
-void add_node ( Node* node, Node** array, int len, int (*cmp)(Node* a, Node* b) ) {
-    /* Adds a given node to the heap and restructures the heap into proper heap structure following
-    the rules described by the given cmp function. */
-
-    if (DEBUG_H) printf("Add node %d\n", node->f_cost);
-
-    // Allocate memory for new node and insert it at the end.
-    array[len-1] = node;
-    
-    // Reorganize the array until it is a proper heap structure following the rules described by
-    // the given cmp function.
-    int parent_index, index = len-1;
-    while (1) {
-        // Repeatedly compare the leaf with its parent. If out of position, swap them and check the
-        // node's new parent (unless the node is now the root).
-
-        parent_index = get_parent_index(index);
-        if (index == 0) {
-            // The node is at the root. No more parents to check. Must be in correct position.
-            node->heap_index = index;
-            break;
-        }
-
-        if (cmp(array[index], array[parent_index])) {
-            // Node must be out of position relative to its parent.
-            swap_nodes(&array[index], &array[parent_index]);
-            index = parent_index;
-        } else {
-            // Node must be in the correct position relative to its parents. Array must be in
-            // proper heap structure now.
-            node->heap_index = index;
-            break;
-        }
-
-        
-    }
-}
-
-int get_parent_index(int child_index) {
-    // Given the index of an array, returns the index of its parent. If it does
-    // not have a parent (i.e. its the root), it will return its own index. This
-    // is dealt with uniquely in the functions that call this one.
-
-    return (child_index - 1)  / 2;
-}
-
-int get_first_child_index(int parent_index) {
-    // Given the index of an array, returns the index of its parent. If it does
-    // not have a parent (i.e. its the root), it will return its own index. This
-    // is dealt with uniquely in the functions that call this one.
-
-    if (DEBUG_H) printf("Parent_i %d -> Child_i %d\n", parent_index, 2 * parent_index + 1);
-    return (2 * parent_index + 1);
-}
-
-void check_node( Node** array, int len, int index, int (*cmp)(Node* a, Node* b) ) {
-    /* Given the index of an array, checks whether its in the correct heap 
-    position relative to its children according to the rules of the given cmp 
-    function. If not, switches with one of the children and recursively calls 
-    this function on the node at the new position. */
-
-    // Determine the number of children that the nodes has and save their 
-    // indices in an array.
-    int children = 0;
-    int children_index_arr[2];
-    children += ( children_index_arr[0] = get_first_child_index(index) ) <= (len - 1);
-    children += ( children_index_arr[1] = get_first_child_index(index) + 1 ) <= (len - 1);
-    if (DEBUG_H) printf("Checknode! Index: %d | Number: %d | Children: %d\n", index, array[index]->f_cost, children);
-
-    // Determine which child to swap with to fulfill the heap structure and swap
-    // if necessary. TODO: COMMENT
-    if (children == 1) {
-        if (cmp(array[children_index_arr[0]], array[index])) {
-            swap_nodes(&array[index], &array[children_index_arr[0]]);
-            check_node(array, len, children_index_arr[0], cmp);
-        } else if (DEBUG_H) {
-            printf("Correct order, no swap.\n");
-        }
-    } else if (children == 2) {
-        int important_child_index;
-        int cmp_result = cmp(array[children_index_arr[0]], array[children_index_arr[1]]);
-        if (cmp_result == 1) {
-            important_child_index = children_index_arr[0];
-        } else {
-            important_child_index = children_index_arr[1];
-        }
-
-        if (cmp(array[important_child_index], array[index])) {        
-            swap_nodes(&array[index], &array[important_child_index]);
-            check_node(array, len, important_child_index, cmp);
-        }
-    } else if (DEBUG_H) {
-        printf("Exit check_node, no children.\n");
+static inline int node_before(Node* a, Node* b) {
+    // The order of the open lists: lowest f_cost first, and lowest h_cost of those.
+    if (a->f_cost == b->f_cost) {
+        return (a->h_cost < b->h_cost);
     }
+    return (a->f_cost < b->f_cost);
 }
 
-void swap_nodes(Node** num1, Node** num2) {
-    if (DEBUG_H) printf("Swap!\n");
-    Node* temp = *num1;
-    *num1 = *num2;
-    *num2 = temp;
-}
\ No newline at end of file
+// The open lists of every search (node_heap_push and so on).
+DEFINE_HEAP(node_heap, Node, HEAP_ARITY, node_before)
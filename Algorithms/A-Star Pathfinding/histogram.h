@@ -0,0 +1,95 @@
+// A latency histogram that any number of threads can add to at once, shared by the server (see
+// server.h) and the load generator of its client (client.c).
+//
+// Values (nanoseconds) are counted in buckets whose width grows with the value: below
+// HISTOGRAM_SUB_BUCKETS every value has its own bucket, and above it each power of two is split
+// into HISTOGRAM_SUB_BUCKETS equal buckets. Any value is then known to within 1 part in 16
+// (6.25%), from 1 ns to centuries, in under 1000 counters, and adding a value is one atomic
+// increment of the bucket found from the position of its highest bit. Percentiles are read off
+// by counting through the buckets, and reported as the highest value of the bucket they fall in.
+
+#include <stdatomic.h>
+
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((65 - HISTOGRAM_SUB_BITS) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    atomic_uint_least64_t counts[HISTOGRAM_BUCKETS];
+    atomic_uint_least64_t num_values;
+    atomic_uint_least64_t sum;
+    atomic_uint_least64_t max;
+} Histogram;
+
+// Function declarations --------------------------------------------------------------------------
+
+void clear_histogram(Histogram* histogram);
+void add_to_histogram(Histogram* histogram, uint64_t value);
+int get_histogram_bucket(uint64_t value);
+uint64_t get_bucket_start(int bucket);
+uint64_t get_percentile(Histogram* histogram, double percentile);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void clear_histogram(Histogram* histogram) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        atomic_store(&histogram->counts[i], 0);
+    }
+    atomic_store(&histogram->num_values, 0);
+    atomic_store(&histogram->sum, 0);
+    atomic_store(&histogram->max, 0);
+}
+
+void add_to_histogram(Histogram* histogram, uint64_t value) {
+    atomic_fetch_add_explicit(&histogram->counts[get_histogram_bucket(value)], 1,
+        memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->num_values, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value,
+        memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+int get_histogram_bucket(uint64_t value) {
+    /* Returns the bucket of a value: the value itself if it is small, and otherwise its power of
+    two's group of buckets, offset by the HISTOGRAM_SUB_BITS bits below its highest one. */
+
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int) value;
+    }
+    int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + (int) ((value >> shift) - HISTOGRAM_SUB_BUCKETS);
+}
+
+uint64_t get_bucket_start(int bucket) {
+    // Returns the lowest value of a bucket.
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    return (uint64_t) (HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+uint64_t get_percentile(Histogram* histogram, double percentile) {
+    /* Returns the value that percentile (0 to 100) percent of the values are at most, rounded up
+    to the end of its bucket but never above the largest value, or 0 if there are none. */
+
+    uint64_t num_values = atomic_load(&histogram->num_values);
+    uint64_t rank = (uint64_t) (percentile / 100 * num_values + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS && num_values > 0; i++) {
+        count += atomic_load(&histogram->counts[i]);
+        if (count >= rank) {
+            uint64_t end = (i + 1 < HISTOGRAM_BUCKETS) ? get_bucket_start(i + 1) - 1 : UINT64_MAX;
+            uint64_t max = atomic_load(&histogram->max);
+            return (end < max) ? end : max;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,733 @@
+// Hierarchical path-finding A* (HPA*; Botea, Müller and Schaeffer, 2004) for very large maps.
+//
+// The map is split into square clusters of cluster_size cells. Wherever a path can cross the
+// border between two clusters, a pair of cells facing each other across it becomes an entrance,
+// and those cells become the nodes of a much smaller abstract graph. Entrance cells of the same
+// cluster are joined by edges costing their shortest path inside the cluster, and the two cells of
+// an entrance by an edge of one step. All of this is built once per map.
+//
+// A query joins the start and end to the entrances of their own clusters, runs A* over the
+// abstract graph, and then refines each edge of the abstract path into cells with a small search
+// inside one cluster. The work done per query grows with the number of clusters along the path,
+// not with the area of the map a plain search would explore.
+//
+// Entrances: along each border, every stretch of cells that is open on both sides is cut into
+// pieces of at most ENTRANCE_WIDTH cells, with one entrance in the middle of each piece. Where
+// the two sides can only be crossed diagonally (both straight crossings are blocked), the
+// diagonal step is an entrance of its own. So a path exists through the abstract graph whenever
+// one exists on the map.
+//
+// Error bound: every edge of the abstract graph is an exact shortest path, so only the places a
+// path crosses a border can cost extra. A crossing within a stretch of open cells is at most
+// ENTRANCE_WIDTH / 2 cells from an entrance, so it can be moved there by walking along the border
+// and back on the other side, and a diagonal crossing costs at most one extra straight step
+// (2 * PRECISION_MULT - SQRT_2) to turn into a straight one. A path found with HPA* therefore
+// costs at most HPA_CROSSING_ERROR more than the shortest path for every border the shortest
+// path crosses (a crossing at a cluster's corner counts as two). On maps with terrain, the extra
+// steps cost as much as the cells they cross, so the bound grows up to MAX_TERRAIN_COST times.
+
+#define ENTRANCE_WIDTH 5
+#define HPA_CROSSING_ERROR (2 * (ENTRANCE_WIDTH / 2) * PRECISION_MULT + 2 * PRECISION_MULT - SQRT_2)
+#define INIT_EDGES 4
+
+typedef struct {
+    uint32_t to;  // Abstract node index.
+    int cost;
+} AbstractEdge;
+
+// A cell where paths enter or leave its cluster.
+typedef struct {
+    uint32_t cell_index;
+    int cluster;
+    AbstractEdge* edges;
+    int num_edges;
+    int curr_size;
+} AbstractNode;
+
+typedef struct {
+    int* nodes; // Abstract node indices of the cluster's entrance cells.
+    int num_nodes;
+    int curr_size;
+} Cluster;
+
+// The abstract graph of a map. Only read by queries, so it can be shared between threads.
+typedef struct {
+    Grid* grid;
+    int cluster_size;
+    int num_cluster_rows;
+    int num_cluster_cols;
+    Cluster* clusters;
+    AbstractNode* nodes;
+    int num_nodes;
+    int curr_size;
+    int num_edges;
+} Hpa;
+
+// The state of HPA* queries over one Hpa. Abstract nodes are numbered like in the Hpa, followed by
+// the query's start and end. Cluster searches use their own nodes, indexed by the position of the
+// cell in the cluster. Both kinds of nodes are stamped with generations like a Search's.
+typedef struct {
+    Hpa* hpa;
+    Node* nodes;
+    Node** open_nodes;
+    int num_open_nodes;
+    uint32_t generation;
+    Node* cluster_nodes;
+    Node** cluster_open_nodes;
+    int num_cluster_open_nodes;
+    uint32_t cluster_generation;
+    int cluster_row;  // First row and column of the cluster being searched.
+    int cluster_col;
+    uint32_t start_index;
+    uint32_t end_index;
+    AbstractEdge* start_edges;
+    AbstractEdge* end_edges;
+    int num_start_edges;
+    int num_end_edges;
+    int end_cluster;
+    uint32_t* path;   // The refined path of the last query, from start to end.
+    int path_len;
+    int path_size;
+    int num_expanded;
+    int num_reopened;
+    int num_decreased;
+    int num_pushes;
+    int num_pops;
+    int64_t num_sift_levels; // Like a Heap's, over both the abstract and the cluster searches.
+    int max_sift_depth;
+    int peak_open_nodes;
+} HpaSearch;
+
+// Function declarations --------------------------------------------------------------------------
+
+void build_hpa(Hpa* hpa, Grid* grid, int cluster_size);
+void add_border_entrances(Hpa* hpa, int row, int col, int step_row, int step_col, int cross_row,
+    int cross_col, int len);
+void add_entrance(Hpa* hpa, uint32_t index1, uint32_t index2);
+int get_abstract_node(Hpa* hpa, uint32_t index);
+void add_abstract_edge(AbstractNode* node, uint32_t to, int cost);
+int get_cluster(Hpa* hpa, uint32_t index);
+int is_free(Grid* grid, int row, int col);
+void init_hpa_search(HpaSearch* search, Hpa* hpa);
+int find_hpa_path(HpaSearch* search, uint32_t start_index, uint32_t end_index);
+int search_abstract_graph(HpaSearch* search);
+Node* get_abstract_search_node(HpaSearch* search, uint32_t index);
+uint32_t get_abstract_cell(HpaSearch* search, uint32_t index);
+void refine_path(HpaSearch* search);
+void append_path(HpaSearch* search, uint32_t index);
+int search_cluster(HpaSearch* search, uint32_t from_index, uint32_t to_index);
+Node* get_cluster_node(HpaSearch* search, int row, int col);
+int get_cluster_distance(HpaSearch* search, uint32_t index);
+void count_hpa_push(HpaSearch* search, int num_levels, int num_open_nodes);
+void count_hpa_pop(HpaSearch* search, int num_levels);
+void count_hpa_sift(HpaSearch* search, int num_levels);
+void get_hpa_counts(HpaSearch* search, Counts* counts);
+void free_hpa_search(HpaSearch* search);
+void free_hpa(Hpa* hpa);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void build_hpa(Hpa* hpa, Grid* grid, int cluster_size) {
+    /* Splits the grid into clusters, finds the entrances on every border between two clusters,
+    and joins the entrances of each cluster with the cost of the shortest path between them. */
+
+    hpa->grid = grid;
+    hpa->cluster_size = cluster_size;
+    hpa->num_cluster_rows = (grid->num_rows + cluster_size - 1) / cluster_size;
+    hpa->num_cluster_cols = (grid->num_cols + cluster_size - 1) / cluster_size;
+    hpa->clusters = calloc( (size_t) hpa->num_cluster_rows * hpa->num_cluster_cols,
+        sizeof *(hpa->clusters) );
+    hpa->curr_size = INIT_HEAP_SIZE;
+    hpa->nodes = malloc(hpa->curr_size * sizeof *(hpa->nodes));
+    hpa->num_nodes = 0;
+    hpa->num_edges = 0;
+
+    for (int i = 0; i < hpa->num_cluster_rows; i++) {
+        for (int j = 0; j < hpa->num_cluster_cols; j++) {
+            int row = i * cluster_size, col = j * cluster_size;
+            int height = num_min(cluster_size, grid->num_rows - row);
+            int width = num_min(cluster_size, grid->num_cols - col);
+
+            // The border with the cluster below, and with the cluster to the right.
+            if (i + 1 < hpa->num_cluster_rows) {
+                add_border_entrances(hpa, row + height - 1, col, 0, 1, 1, 0, width);
+            }
+            if (j + 1 < hpa->num_cluster_cols) {
+                add_border_entrances(hpa, row, col + width - 1, 1, 0, 0, 1, height);
+            }
+
+            // The corner with the cluster diagonally below on either side, if it can only be
+            // crossed diagonally.
+            int corner_row = row + height - 1, corner_col = col + width - 1;
+            if (i + 1 < hpa->num_cluster_rows && j + 1 < hpa->num_cluster_cols &&
+                !is_free(grid, corner_row, corner_col + 1) &&
+                !is_free(grid, corner_row + 1, corner_col) &&
+                is_free(grid, corner_row, corner_col) &&
+                is_free(grid, corner_row + 1, corner_col + 1)) {
+                add_entrance(hpa, get_index(grid, corner_row, corner_col),
+                    get_index(grid, corner_row + 1, corner_col + 1));
+            }
+            if (i + 1 < hpa->num_cluster_rows && j > 0 &&
+                !is_free(grid, corner_row, col - 1) && !is_free(grid, corner_row + 1, col) &&
+                is_free(grid, corner_row, col) && is_free(grid, corner_row + 1, col - 1)) {
+                add_entrance(hpa, get_index(grid, corner_row, col),
+                    get_index(grid, corner_row + 1, col - 1));
+            }
+        }
+    }
+
+    // Join the entrances of each cluster with a search from each of them over the cluster.
+    HpaSearch scratch;
+    init_hpa_search(&scratch, hpa);
+    int num_clusters = hpa->num_cluster_rows * hpa->num_cluster_cols;
+    for (int i = 0; i < num_clusters; i++) {
+        Cluster* cluster = &hpa->clusters[i];
+        for (int j = 0; j < cluster->num_nodes; j++) {
+            AbstractNode* node = &hpa->nodes[cluster->nodes[j]];
+            search_cluster(&scratch, node->cell_index, NO_INDEX);
+
+            for (int k = 0; k < cluster->num_nodes; k++) {
+                int cost = get_cluster_distance(&scratch, hpa->nodes[cluster->nodes[k]].cell_index);
+                if (k != j && cost != -1) {
+                    add_abstract_edge(node, cluster->nodes[k], cost);
+                    hpa->num_edges++;
+                }
+            }
+        }
+    }
+
+    free_hpa_search(&scratch);
+}
+
+void add_border_entrances(Hpa* hpa, int row, int col, int step_row, int step_col, int cross_row,
+    int cross_col, int len) {
+    /* Adds the entrances along one border. The border's cells on the first side are the len
+    cells from (row, col) in steps of (step_row, step_col), and the cell facing each of them is one
+    step of (cross_row, cross_col) away. */
+
+    Grid* grid = hpa->grid;
+    int run_start = -1;
+
+    for (int k = 0; k <= len; k++) {
+        int r = row + k * step_row, c = col + k * step_col;
+        int open = (k < len) && is_free(grid, r, c) && is_free(grid, r + cross_row, c + cross_col);
+
+        if (open && run_start == -1) {
+            run_start = k;
+        } else if (!open && run_start != -1) {
+            // Cut the stretch of open crossings from run_start to k - 1 into pieces, with an
+            // entrance in the middle of each.
+            for (int piece = run_start; piece < k; piece += ENTRANCE_WIDTH) {
+                int middle = (piece + num_min(piece + ENTRANCE_WIDTH, k) - 1) / 2;
+                int mr = row + middle * step_row, mc = col + middle * step_col;
+                add_entrance(hpa, get_index(grid, mr, mc),
+                    get_index(grid, mr + cross_row, mc + cross_col));
+            }
+            run_start = -1;
+        }
+
+        // Crossings that can only be made diagonally, to the next cell along the border or from it.
+        if (k + 1 < len) {
+            int nr = r + step_row, nc = c + step_col;
+            int here = is_free(grid, r, c), there = is_free(grid, r + cross_row, c + cross_col);
+            int next_here = is_free(grid, nr, nc);
+            int next_there = is_free(grid, nr + cross_row, nc + cross_col);
+
+            if (here && next_there && !there && !next_here) {
+                add_entrance(hpa, get_index(grid, r, c),
+                    get_index(grid, nr + cross_row, nc + cross_col));
+            } else if (next_here && there && !here && !next_there) {
+                add_entrance(hpa, get_index(grid, nr, nc),
+                    get_index(grid, r + cross_row, c + cross_col));
+            }
+        }
+    }
+}
+
+void add_entrance(Hpa* hpa, uint32_t index1, uint32_t index2) {
+    // Joins two cells on either side of a border, adding them to the abstract graph if needed.
+    int cost = get_step_cost(hpa->grid, index1, index2);
+    int node1 = get_abstract_node(hpa, index1);
+    int node2 = get_abstract_node(hpa, index2);
+    add_abstract_edge(&hpa->nodes[node1], node2, cost);
+    add_abstract_edge(&hpa->nodes[node2], node1, cost);
+    hpa->num_edges += 2;
+}
+
+int get_abstract_node(Hpa* hpa, uint32_t index) {
+    /* Returns the abstract node of a cell, adding one to the cell's cluster if the cell isn't in
+    the abstract graph yet. */
+
+    Cluster* cluster = &hpa->clusters[get_cluster(hpa, index)];
+    for (int i = 0; i < cluster->num_nodes; i++) {
+        if (hpa->nodes[cluster->nodes[i]].cell_index == index) {
+            return cluster->nodes[i];
+        }
+    }
+
+    if (hpa->num_nodes == hpa->curr_size) {
+        hpa->curr_size *= 2;
+        hpa->nodes = realloc(hpa->nodes, hpa->curr_size * sizeof *(hpa->nodes));
+    }
+    AbstractNode* node = &hpa->nodes[hpa->num_nodes];
+    node->cell_index = index;
+    node->cluster = get_cluster(hpa, index);
+    node->edges = NULL;
+    node->num_edges = 0;
+    node->curr_size = 0;
+
+    if (cluster->num_nodes == cluster->curr_size) {
+        cluster->curr_size = (cluster->curr_size) ? cluster->curr_size * 2 : INIT_EDGES;
+        cluster->nodes = realloc(cluster->nodes, cluster->curr_size * sizeof *(cluster->nodes));
+    }
+    cluster->nodes[cluster->num_nodes++] = hpa->num_nodes;
+
+    return hpa->num_nodes++;
+}
+
+void add_abstract_edge(AbstractNode* node, uint32_t to, int cost) {
+    if (node->num_edges == node->curr_size) {
+        node->curr_size = (node->curr_size) ? node->curr_size * 2 : INIT_EDGES;
+        node->edges = realloc(node->edges, node->curr_size * sizeof *(node->edges));
+    }
+    node->edges[node->num_edges].to = to;
+    node->edges[node->num_edges++].cost = cost;
+}
+
+int get_cluster(Hpa* hpa, uint32_t index) {
+    // Returns the index of the cluster a cell is in.
+    int row = get_row(hpa->grid, index), col = get_col(hpa->grid, index);
+    return (row / hpa->cluster_size) * hpa->num_cluster_cols + col / hpa->cluster_size;
+}
+
+int is_free(Grid* grid, int row, int col) {
+    // Returns whether a cell is on the map and not an obstacle.
+    return row >= 0 && row < grid->num_rows && col >= 0 && col < grid->num_cols &&
+        !is_obstacle(grid, get_index(grid, row, col));
+}
+
+void init_hpa_search(HpaSearch* search, Hpa* hpa) {
+    /* Allocates the state of HPA* queries over hpa, whose abstract graph must not grow any more
+    (except while building it, when only cluster searches are run). */
+
+    size_t cluster_cells = (size_t) hpa->cluster_size * hpa->cluster_size;
+
+    search->hpa = hpa;
+    search->nodes = NULL;
+    search->open_nodes = NULL;
+    search->generation = 0;
+    search->cluster_nodes = calloc(cluster_cells, sizeof *(search->cluster_nodes));
+    search->cluster_open_nodes = malloc(cluster_cells * sizeof *(search->cluster_open_nodes));
+    search->cluster_generation = 0;
+    search->start_edges = NULL;
+    search->end_edges = NULL;
+    search->path_size = INIT_HEAP_SIZE;
+    search->path = malloc(search->path_size * sizeof *(search->path));
+    search->path_len = 0;
+    search->num_expanded = search->num_reopened = search->num_decreased = 0;
+    search->num_pushes = search->num_pops = 0;
+    search->num_sift_levels = 0;
+    search->max_sift_depth = search->peak_open_nodes = 0;
+}
+
+int find_hpa_path(HpaSearch* search, uint32_t start_index, uint32_t end_index) {
+    /* Finds a path from start_index to end_index through the abstract graph, and refines it into
+    search->path. Returns its cost, or -1 if there is no path. */
+
+    Hpa* hpa = search->hpa;
+    search->num_expanded = 0;
+    search->num_reopened = 0;
+    search->num_decreased = 0;
+    search->num_pushes = 0;
+    search->num_pops = 0;
+    search->num_sift_levels = 0;
+    search->max_sift_depth = 0;
+    search->peak_open_nodes = 0;
+    search->path_len = 0;
+    search->start_index = start_index;
+    search->end_index = end_index;
+
+    Grid* grid = hpa->grid;
+    if (!same_component(grid, start_index, end_index)) {
+        return -1;
+    }
+
+    if (search->nodes == NULL) {
+        // The first query: the abstract graph is complete now.
+        search->nodes = calloc(hpa->num_nodes + 2, sizeof *(search->nodes));
+        search->open_nodes = malloc((hpa->num_nodes + 2) * sizeof *(search->open_nodes));
+        search->start_edges = malloc((hpa->num_nodes + 2) * sizeof *(search->start_edges));
+        search->end_edges = malloc((hpa->num_nodes + 2) * sizeof *(search->end_edges));
+    }
+
+    // Join the start to every entrance of its cluster, and every entrance of the end's cluster to
+    // the end. If both are in the same cluster, the start is also joined to the end directly.
+    uint32_t end_node = hpa->num_nodes + 1;
+    int start_cluster = get_cluster(hpa, start_index);
+    search->end_cluster = get_cluster(hpa, end_index);
+
+    search_cluster(search, start_index, NO_INDEX);
+    search->num_start_edges = 0;
+    Cluster* cluster = &hpa->clusters[start_cluster];
+    for (int i = 0; i < cluster->num_nodes; i++) {
+        int cost = get_cluster_distance(search, hpa->nodes[cluster->nodes[i]].cell_index);
+        if (cost != -1) {
+            search->start_edges[search->num_start_edges].to = cluster->nodes[i];
+            search->start_edges[search->num_start_edges++].cost = cost;
+        }
+    }
+    if (start_cluster == search->end_cluster && get_cluster_distance(search, end_index) != -1) {
+        search->start_edges[search->num_start_edges].to = end_node;
+        search->start_edges[search->num_start_edges++].cost = get_cluster_distance(search,
+            end_index);
+    }
+
+    search_cluster(search, end_index, NO_INDEX);
+    search->num_end_edges = 0;
+    cluster = &hpa->clusters[search->end_cluster];
+    for (int i = 0; i < cluster->num_nodes; i++) {
+        int cost = get_cluster_distance(search, hpa->nodes[cluster->nodes[i]].cell_index);
+        if (cost != -1) {
+            search->end_edges[search->num_end_edges].to = cluster->nodes[i];
+            search->end_edges[search->num_end_edges++].cost = cost;
+        }
+    }
+
+    int path_cost = search_abstract_graph(search);
+    if (path_cost != -1) {
+        refine_path(search);
+    }
+    return path_cost;
+}
+
+int search_abstract_graph(HpaSearch* search) {
+    /* Runs A* over the abstract graph from the query's start to its end, with the octile distance
+    as h_cost. Returns the cost of the path, or -1 if there is none. */
+
+    Hpa* hpa = search->hpa;
+    uint32_t start_node = hpa->num_nodes, end_node = hpa->num_nodes + 1;
+
+    search->generation++;
+    if (search->generation == 0) {
+        for (int i = 0; i < hpa->num_nodes + 2; i++) {
+            search->nodes[i].generation = 0;
+        }
+        search->generation = 1;
+    }
+
+    Node* start = get_abstract_search_node(search, start_node);
+    start->g_cost = 0;
+    start->h_cost = get_min_distance(hpa->grid, get_abstract_cell(search, start_node),
+        get_abstract_cell(search, end_node));
+    start->f_cost = start->h_cost;
+    start->prev_index = start_node;
+    start->analyzed_once = 1;
+    search->num_open_nodes = 0;
+    node_heap_push(start, search->open_nodes, ++(search->num_open_nodes));
+    count_hpa_push(search, 0, search->num_open_nodes);
+
+    while (search->num_open_nodes) {
+        int num_levels;
+        Node* node = node_heap_pop(search->open_nodes, (search->num_open_nodes)--, &num_levels);
+        count_hpa_pop(search, num_levels);
+        uint32_t index = node - search->nodes;
+        node->is_open = 0;
+        search->num_expanded++;
+
+        if (index == end_node) {
+            return node->g_cost;
+        }
+
+        // The edges of the start are the query's, and entrances of the end's cluster also lead to
+        // the end.
+        AbstractEdge* edges = (index == start_node) ? search->start_edges : hpa->nodes[index].edges;
+        int num_edges = (index == start_node) ? search->num_start_edges
+                                              : hpa->nodes[index].num_edges;
+        int end_cost = -1;
+        if (index != start_node && hpa->nodes[index].cluster == search->end_cluster) {
+            for (int i = 0; i < search->num_end_edges; i++) {
+                if (search->end_edges[i].to == index) {
+                    end_cost = search->end_edges[i].cost;
+                }
+            }
+        }
+
+        for (int i = -1; i < num_edges; i++) {
+            uint32_t next_index = (i == -1) ? end_node : edges[i].to;
+            int cost = (i == -1) ? end_cost : edges[i].cost;
+            if (cost == -1) {
+                continue;
+            }
+
+            Node* next = get_abstract_search_node(search, next_index);
+            int g_cost = node->g_cost + cost;
+            if (!next->is_open || (next->analyzed_once && g_cost >= next->g_cost)) {
+                continue;
+            }
+
+            next->g_cost = g_cost;
+            next->prev_index = index;
+            if (!next->analyzed_once) {
+                next->h_cost = get_min_distance(hpa->grid, get_abstract_cell(search, next_index),
+                    get_abstract_cell(search, end_node));
+                next->f_cost = next->g_cost + next->h_cost;
+                next->analyzed_once = 1;
+                search->num_open_nodes++;
+                count_hpa_push(search, node_heap_push(next, search->open_nodes,
+                    search->num_open_nodes), search->num_open_nodes);
+            } else {
+                next->f_cost = next->g_cost + next->h_cost;
+                search->num_decreased++;
+                count_hpa_sift(search, node_heap_sift_up(search->open_nodes, next->heap_index));
+            }
+        }
+    }
+
+    return -1;
+}
+
+Node* get_abstract_search_node(HpaSearch* search, uint32_t index) {
+    // Like get_node, for the abstract nodes of the current query.
+    Node* node = &search->nodes[index];
+    if (node->generation != search->generation) {
+        node->generation = search->generation;
+        node->is_open = 1;
+        node->analyzed_once = 0;
+        node->heap_index = -1;
+    }
+    return node;
+}
+
+uint32_t get_abstract_cell(HpaSearch* search, uint32_t index) {
+    // Returns the cell of an abstract node, including the query's start and end.
+    Hpa* hpa = search->hpa;
+    if (index == (uint32_t) hpa->num_nodes) {
+        return search->start_index;
+    } else if (index == (uint32_t) hpa->num_nodes + 1) {
+        return search->end_index;
+    }
+    return hpa->nodes[index].cell_index;
+}
+
+void refine_path(HpaSearch* search) {
+    /* Turns the abstract path found into cells. Two abstract nodes in different clusters are
+    neighboring cells, and two in the same cluster are joined with a search inside it. */
+
+    Hpa* hpa = search->hpa;
+    uint32_t start_node = hpa->num_nodes, end_node = hpa->num_nodes + 1;
+
+    // Reverse the abstract path so it runs from the start, reusing the open list's memory.
+    int num_abstract = 0;
+    Node** abstract_path = search->open_nodes;
+    for (uint32_t index = end_node; index != start_node; index = search->nodes[index].prev_index) {
+        abstract_path[num_abstract++] = &search->nodes[index];
+    }
+    abstract_path[num_abstract++] = &search->nodes[start_node];
+
+    append_path(search, get_abstract_cell(search, start_node));
+    for (int i = num_abstract - 2; i >= 0; i--) {
+        uint32_t from = get_abstract_cell(search, abstract_path[i + 1] - search->nodes);
+        uint32_t to = get_abstract_cell(search, abstract_path[i] - search->nodes);
+        if (from == to) {
+            continue;
+        }
+        if (get_cluster(hpa, from) != get_cluster(hpa, to)) {
+            append_path(search, to);
+            continue;
+        }
+
+        // Follow the cluster search back from its end, then put the cells in order.
+        search_cluster(search, from, to);
+        int first = search->path_len;
+        for (uint32_t index = to; index != from; ) {
+            append_path(search, index);
+            int size = hpa->cluster_size;
+            int row = get_row(hpa->grid, index), col = get_col(hpa->grid, index);
+            uint32_t prev = get_cluster_node(search, row, col)->prev_index;
+            index = get_index(hpa->grid, search->cluster_row + prev / size,
+                search->cluster_col + prev % size);
+        }
+        for (int a = first, b = search->path_len - 1; a < b; a++, b--) {
+            uint32_t temp = search->path[a];
+            search->path[a] = search->path[b];
+            search->path[b] = temp;
+        }
+    }
+}
+
+void append_path(HpaSearch* search, uint32_t index) {
+    if (search->path_len == search->path_size) {
+        search->path_size *= 2;
+        search->path = realloc(search->path, search->path_size * sizeof *(search->path));
+    }
+    search->path[search->path_len++] = index;
+}
+
+int search_cluster(HpaSearch* search, uint32_t from_index, uint32_t to_index) {
+    /* Runs A* from from_index to to_index without leaving from_index's cluster, or Dijkstra's
+    algorithm over the whole cluster if to_index is NO_INDEX. Returns the cost of the path found,
+    or -1 if to_index can't be reached inside the cluster. A node's prev_index is the position of
+    the node it was reached from in the cluster. */
+
+    Hpa* hpa = search->hpa;
+    Grid* grid = hpa->grid;
+    int size = hpa->cluster_size;
+    int from_row = get_row(grid, from_index), from_col = get_col(grid, from_index);
+    int to_row = get_row(grid, to_index), to_col = get_col(grid, to_index);
+
+    search->cluster_row = from_row / size * size;
+    search->cluster_col = from_col / size * size;
+    int last_row = num_min(search->cluster_row + size, grid->num_rows) - 1;
+    int last_col = num_min(search->cluster_col + size, grid->num_cols) - 1;
+
+    search->cluster_generation++;
+    if (search->cluster_generation == 0) {
+        for (int i = 0; i < size * size; i++) {
+            search->cluster_nodes[i].generation = 0;
+        }
+        search->cluster_generation = 1;
+    }
+
+    Node* start = get_cluster_node(search, from_row, from_col);
+    start->g_cost = 0;
+    start->h_cost = (to_index == NO_INDEX) ? 0 : get_min_distance(grid, from_index, to_index);
+    start->f_cost = start->h_cost;
+    start->prev_index = (from_row - search->cluster_row) * size + from_col - search->cluster_col;
+    start->analyzed_once = 1;
+    search->num_cluster_open_nodes = 0;
+    node_heap_push(start, search->cluster_open_nodes, ++(search->num_cluster_open_nodes));
+    count_hpa_push(search, 0, search->num_cluster_open_nodes);
+
+    while (search->num_cluster_open_nodes) {
+        int num_levels;
+        Node* node = node_heap_pop(search->cluster_open_nodes,
+            (search->num_cluster_open_nodes)--, &num_levels);
+        count_hpa_pop(search, num_levels);
+        int position = node - search->cluster_nodes;
+        int row = search->cluster_row + position / size;
+        int col = search->cluster_col + position % size;
+        node->is_open = 0;
+        search->num_expanded++;
+
+        if (row == to_row && col == to_col && to_index != NO_INDEX) {
+            return node->g_cost;
+        }
+
+        for (int r = row - 1; r <= row + 1; r++) {
+            for (int c = col - 1; c <= col + 1; c++) {
+                if ((r == row && c == col) || r < search->cluster_row || r > last_row ||
+                    c < search->cluster_col || c > last_col) {
+                    continue;
+                }
+
+                Node* next = get_cluster_node(search, r, c);
+                if (!next->is_open) {
+                    continue;
+                }
+                uint32_t index = get_index(grid, r, c);
+                int g_cost = node->g_cost + get_step_cost(grid, index,
+                    get_index(grid, row, col));
+                if (next->analyzed_once && g_cost >= next->g_cost) {
+                    continue;
+                }
+
+                next->g_cost = g_cost;
+                next->prev_index = position;
+                if (!next->analyzed_once) {
+                    next->h_cost = (to_index == NO_INDEX) ? 0 : get_min_distance(grid, index,
+                        to_index);
+                    next->f_cost = next->g_cost + next->h_cost;
+                    next->analyzed_once = 1;
+                    search->num_cluster_open_nodes++;
+                    count_hpa_push(search, node_heap_push(next, search->cluster_open_nodes,
+                        search->num_cluster_open_nodes), search->num_cluster_open_nodes);
+                } else {
+                    next->f_cost = next->g_cost + next->h_cost;
+                    search->num_decreased++;
+                    count_hpa_sift(search, node_heap_sift_up(search->cluster_open_nodes,
+                        next->heap_index));
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+Node* get_cluster_node(HpaSearch* search, int row, int col) {
+    /* Like get_node, for the cell at (row, col) of the cluster being searched. */
+    Hpa* hpa = search->hpa;
+    int size = hpa->cluster_size;
+    Node* node = &search->cluster_nodes[(row - search->cluster_row) * size + col -
+        search->cluster_col];
+    if (node->generation != search->cluster_generation) {
+        node->generation = search->cluster_generation;
+        node->is_open = !is_obstacle(hpa->grid, get_index(hpa->grid, row, col));
+        node->analyzed_once = 0;
+        node->heap_index = -1;
+    }
+    return node;
+}
+
+int get_cluster_distance(HpaSearch* search, uint32_t index) {
+    /* Returns the distance to a cell found by the last cluster search, or -1 if it wasn't
+    reached. The cell must be in the cluster searched. */
+    Grid* grid = search->hpa->grid;
+    Node* node = get_cluster_node(search, get_row(grid, index), get_col(grid, index));
+    return node->analyzed_once ? node->g_cost : -1;
+}
+
+void count_hpa_push(HpaSearch* search, int num_levels, int num_open_nodes) {
+    // Counts a push onto either open list, which now holds num_open_nodes nodes.
+    search->num_pushes++;
+    count_hpa_sift(search, num_levels);
+    if (num_open_nodes > search->peak_open_nodes) {
+        search->peak_open_nodes = num_open_nodes;
+    }
+}
+
+void count_hpa_pop(HpaSearch* search, int num_levels) {
+    search->num_pops++;
+    count_hpa_sift(search, num_levels);
+}
+
+void count_hpa_sift(HpaSearch* search, int num_levels) {
+    // Like count_sift, for either open list of an HPA* query.
+    search->num_sift_levels += num_levels;
+    if (num_levels > search->max_sift_depth) {
+        search->max_sift_depth = num_levels;
+    }
+}
+
+void get_hpa_counts(HpaSearch* search, Counts* counts) {
+    // Like get_search_counts, for the last HPA* query.
+    counts->num_expanded = search->num_expanded;
+    counts->num_reopened = search->num_reopened;
+    counts->num_decreased = search->num_decreased;
+    counts->num_pushes = search->num_pushes;
+    counts->num_pops = search->num_pops;
+    counts->num_sift_levels = search->num_sift_levels;
+    counts->max_sift_depth = search->max_sift_depth;
+    counts->peak_open_nodes = search->peak_open_nodes;
+}
+
+void free_hpa_search(HpaSearch* search) {
+    free(search->nodes);
+    free(search->open_nodes);
+    free(search->cluster_nodes);
+    free(search->cluster_open_nodes);
+    free(search->start_edges);
+    free(search->end_edges);
+    free(search->path);
+}
+
+void free_hpa(Hpa* hpa) {
+    for (int i = 0; i < hpa->num_cluster_rows * hpa->num_cluster_cols; i++) {
+        free(hpa->clusters[i].nodes);
+    }
+    for (int i = 0; i < hpa->num_nodes; i++) {
+        free(hpa->nodes[i].edges);
+    }
+    free(hpa->clusters);
+    free(hpa->nodes);
+}
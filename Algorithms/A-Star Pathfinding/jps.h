@@ -0,0 +1,202 @@
+// Jump Point Search (Harabor and Grastien, 2011) for uniform-cost, 8-connected grids where
+// diagonal moves may cut corners, which is how get_neighbors in main.c moves with MOVES_8.
+//
+// Instead of adding every neighbor of a node to the open list, the search "jumps" in a straight
+// line from the node until it reaches the goal, a wall, or a cell with a forced neighbor (a
+// neighbor that can only be reached optimally through that cell). Only those jump points are
+// added to the open list, which removes the many symmetric paths A* would otherwise expand.
+//
+// Straight jumps read the obstacle bitmap 64 cells at a time. Horizontal jumps scan a bitmap of
+// the rows, and vertical jumps scan a second, transposed bitmap of the columns, so both directions
+// walk along contiguous words.
+
+// A bitmap of obstacles, one line (row or column) after another. A set bit is an obstacle. Each
+// line has one padding bit before its first cell and at least one after its last, and there is a
+// padding line before the first and after the last line. Padding is always set, so scans stop at
+// the edges of the map without any bounds checks.
+typedef struct {
+    uint64_t* bits;
+    int num_lines;
+    int line_len;
+    int words_per_line;
+} Bitmap;
+
+typedef struct {
+    Bitmap rows;
+    Bitmap cols;
+} JumpMap;
+
+// Function declarations --------------------------------------------------------------------------
+
+void init_jump_map(JumpMap* map, int num_rows, int num_cols);
+void set_free(JumpMap* map, int row, int col);
+int is_blocked(JumpMap* map, int row, int col);
+int jump_straight(Bitmap* bitmap, int line, int pos, int dir, int goal_line, int goal_pos);
+int jump_diagonal(JumpMap* map, int* row, int* col, int dx, int dy, int goal_row, int goal_col);
+int get_jump_dirs(JumpMap* map, int row, int col, int dx, int dy, int dirs[][2]);
+void init_bitmap(Bitmap* bitmap, int num_lines, int line_len);
+uint64_t* get_line(Bitmap* bitmap, int line);
+void free_jump_map(JumpMap* map);
+
+// Function declarations end ----------------------------------------------------------------------
+
+void init_jump_map(JumpMap* map, int num_rows, int num_cols) {
+    /* Sets up the row and column bitmaps of a map with every cell an obstacle. Open cells are then
+    cleared one at a time with set_free. */
+
+    init_bitmap(&map->rows, num_rows, num_cols);
+    init_bitmap(&map->cols, num_cols, num_rows);
+}
+
+void set_free(JumpMap* map, int row, int col) {
+    // Marks a cell as traversable in both bitmaps.
+    get_line(&map->rows, row)[(col + 1) / 64] &= ~(1ULL << ((col + 1) % 64));
+    get_line(&map->cols, col)[(row + 1) / 64] &= ~(1ULL << ((row + 1) % 64));
+}
+
+int is_blocked(JumpMap* map, int row, int col) {
+    /* Returns whether a cell is an obstacle. Cells one step outside of the map count as
+    obstacles. */
+    return (get_line(&map->rows, row)[(col + 1) / 64] >> ((col + 1) % 64)) & 1;
+}
+
+int jump_straight(Bitmap* bitmap, int line, int pos, int dir, int goal_line, int goal_pos) {
+    /* Jumps along a line of the bitmap from position pos in direction dir (1 or -1). Returns the
+    position of the jump point found, or -1 if the jump runs into an obstacle first.
+
+    A cell is a jump point if it is the goal or if it has a forced neighbor: a cell on either side
+    of it is an obstacle while the cell diagonally ahead on that side is not. */
+
+    uint64_t* self = get_line(bitmap, line);
+    uint64_t* left = get_line(bitmap, line - 1);
+    uint64_t* right = get_line(bitmap, line + 1);
+    int last_word = bitmap->words_per_line - 1;
+
+    // Bits are positions shifted by one for the padding bit. Start at the cell after pos.
+    int bit = pos + 1 + dir;
+    int word = bit / 64;
+    uint64_t mask = (dir > 0) ? ~0ULL << (bit % 64) : ~0ULL >> (63 - bit % 64);
+
+    while (1) {
+        // For each cell, get whether the cell one step ahead on each side is an obstacle. The
+        // padding guarantees the words beyond either end only matter for padding bits.
+        uint64_t left_ahead, right_ahead;
+        if (dir > 0) {
+            left_ahead = (left[word] >> 1) | ((word < last_word) ? left[word + 1] << 63 : 0);
+            right_ahead = (right[word] >> 1) | ((word < last_word) ? right[word + 1] << 63 : 0);
+        } else {
+            left_ahead = (left[word] << 1) | ((word > 0) ? left[word - 1] >> 63 : 0);
+            right_ahead = (right[word] << 1) | ((word > 0) ? right[word - 1] >> 63 : 0);
+        }
+
+        uint64_t forced = (left[word] & ~left_ahead) | (right[word] & ~right_ahead);
+        uint64_t stops = (self[word] | forced) & mask;
+
+        if (stops) {
+            int stop_bit = (dir > 0) ? word * 64 + __builtin_ctzll(stops)
+                                     : word * 64 + 63 - __builtin_clzll(stops);
+            int stop = stop_bit - 1;
+
+            // The goal is a jump point too, so check whether it was passed on the way.
+            if (line == goal_line && (goal_pos - pos) * dir > 0 && (stop - goal_pos) * dir >= 0) {
+                return goal_pos;
+            }
+
+            return ((self[word] >> (stop_bit % 64)) & 1) ? -1 : stop;
+        }
+
+        word += dir;
+        mask = ~0ULL;
+    }
+}
+
+int jump_diagonal(JumpMap* map, int* row, int* col, int dx, int dy, int goal_row, int goal_col) {
+    /* Jumps diagonally from (row, col) in direction (dx, dy). Returns 1 and moves row and col to
+    the jump point found, or returns 0 if the jump runs into an obstacle first.
+
+    A diagonal cell is a jump point if it is the goal, if it has a forced neighbor, or if a
+    straight jump from it along either component of the direction finds a jump point. */
+
+    int r = *row, c = *col;
+    while (1) {
+        r += dy;
+        c += dx;
+
+        if (is_blocked(map, r, c)) {
+            return 0;
+        }
+
+        if ( (r == goal_row && c == goal_col) ||
+            (is_blocked(map, r, c - dx) && !is_blocked(map, r + dy, c - dx)) ||
+            (is_blocked(map, r - dy, c) && !is_blocked(map, r - dy, c + dx)) ||
+            jump_straight(&map->rows, r, c, dx, goal_row, goal_col) != -1 ||
+            jump_straight(&map->cols, c, r, dy, goal_col, goal_row) != -1) {
+            *row = r;
+            *col = c;
+            return 1;
+        }
+    }
+}
+
+int get_jump_dirs(JumpMap* map, int row, int col, int dx, int dy, int dirs[][2]) {
+    /* Given a node at (row, col) reached by moving in direction (dx, dy), saves the directions
+    worth jumping in from it (its natural and forced neighbors) into dirs and returns how many
+    there are. A direction of (0, 0) means the node is the start, so every direction is tried. */
+
+    int num_dirs = 0;
+
+    if (dx == 0 && dy == 0) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                if (x || y) {
+                    dirs[num_dirs][0] = x;
+                    dirs[num_dirs++][1] = y;
+                }
+            }
+        }
+    } else if (dx && dy) {
+        // Diagonal: keep going, or follow either component. A wall behind either side forces
+        // the diagonal on that side.
+        dirs[num_dirs][0] = dx;  dirs[num_dirs++][1] = dy;
+        dirs[num_dirs][0] = dx;  dirs[num_dirs++][1] = 0;
+        dirs[num_dirs][0] = 0;   dirs[num_dirs++][1] = dy;
+        if (is_blocked(map, row, col - dx)) {
+            dirs[num_dirs][0] = -dx;  dirs[num_dirs++][1] = dy;
+        }
+        if (is_blocked(map, row - dy, col)) {
+            dirs[num_dirs][0] = dx;  dirs[num_dirs++][1] = -dy;
+        }
+    } else {
+        // Straight: keep going. A wall to either side forces the diagonal ahead on that side.
+        dirs[num_dirs][0] = dx;  dirs[num_dirs++][1] = dy;
+        if (is_blocked(map, row + dx, col + dy)) {
+            dirs[num_dirs][0] = dx + dy;  dirs[num_dirs++][1] = dy + dx;
+        }
+        if (is_blocked(map, row - dx, col - dy)) {
+            dirs[num_dirs][0] = dx - dy;  dirs[num_dirs++][1] = dy - dx;
+        }
+    }
+
+    return num_dirs;
+}
+
+void init_bitmap(Bitmap* bitmap, int num_lines, int line_len) {
+    // Allocates a bitmap with every cell, including the padding, set as an obstacle.
+    bitmap->num_lines = num_lines;
+    bitmap->line_len = line_len;
+    bitmap->words_per_line = (line_len + 2 + 63) / 64;
+
+    size_t num_words = (size_t) (num_lines + 2) * bitmap->words_per_line;
+    bitmap->bits = malloc(num_words * sizeof *(bitmap->bits));
+    memset(bitmap->bits, 0xFF, num_words * sizeof *(bitmap->bits));
+}
+
+uint64_t* get_line(Bitmap* bitmap, int line) {
+    // Returns the first word of a line. Lines -1 and num_lines are the padding lines.
+    return &bitmap->bits[(size_t) (line + 1) * bitmap->words_per_line];
+}
+
+void free_jump_map(JumpMap* map) {
+    free(map->rows.bits);
+    free(map->cols.bits);
+}
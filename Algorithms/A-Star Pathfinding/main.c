@@ -1,22 +1,14 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include "heap.h"
-
-#define START 'S'
-#define END 'E'
-#define OBSTACLE 'Z'
-#define EMPTY '_'
-#define NEW_LINE '\n'
-#define PATH_CHAR '.'
-
-// The number of neighbors surrounding a node usually (except edge and corner
-// nodes).
-#define NUM_SURR 8
-#define INIT_HEAP_SIZE 16
-
-#define PRECISION_MULT 10
-#define SQRT_2 (int) (PRECISION_MULT * 1.4142)
+#include "bucket.h"
+#include "jps.h"
+#include "astar.h"
 
 #define RED "\x1B[1;31m"
 #define GREEN "\x1B[1;32m"
@@ -40,313 +32,1124 @@
     #include <unistd.h>
 #endif
 
-// Define global variables.
-int NUM_ROWS;
-int NUM_COLS;
-Node*** grid;
-Node* end_node;
-
-typedef struct {
-    Node** nodes;
-    int curr_size;
-    int num_open_nodes;
-} Heap;
-
-Node*** load_map(char *map_name, Heap* open_nodes);
-Node** get_neighbors(Node*** grid, Node* node);
-int analyze_step(Node*** grid, Node* node, Heap* open_nodes);
-int analyze_node(Node* next_node, Node* curr_node);
-int get_distance(Node* node1, Node* node2);
-int cmp(Node* a, Node* b);
-int num_min(int a, int b);
-void print_grid(Node*** grid);
-void print_node_list(Node** list, int len);
-void add_open_node(Node* node, Heap* open_nodes);
-void draw_path(Node*** grid, Node* end_node);
-void clear_screen();
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "map.h"
+#include "components.h"
+#include "goals.h"
+#include "bidir.h"
+#include "stats.h"
+#include "alt.h"
+#include "hpa.h"
+#include "hda.h"
+#include "flowfield.h"
+#include "ara.h"
+#include "batch.h"
+#include "protocol.h"
+#include "histogram.h"
+#include "server.h"
+#include "dstar.h"
 
 int main(int argc, char *argv[]) {
 
+    int backend = BINARY_HEAP;
+    int jps = 0;
+    int bidirectional = 0;
+    char* query_file = NULL;
+    int num_threads = 0;
+    char* landmark_file = NULL;
+    int num_landmarks = 0;
+    int cluster_size = 0;
+    int hda_threads = 0;
+    char* flow_file = NULL;
+    int make_flow = 0;
+    AraOptions ara = {ARA_EPSILON, ARA_EPSILON_STEP, -1};
+    char* change_file = NULL;
+    char* binary_file = NULL;
+    int print_report = 0;
+    int moves = -1;
+    char* socket_path = NULL;
+    char* map_name = NULL;
+    char** map_names = malloc(argc * sizeof *(map_names));
+    int num_maps = 0;
+
+    // Read the command line: options followed by the map.
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--open-list") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "heap") == 0) {
+                backend = BINARY_HEAP;
+            } else if (strcmp(argv[i], "bucket") == 0) {
+                backend = BUCKET_QUEUE;
+            } else {
+                printf("Unknown open list '%s' (expected heap or bucket). Exiting...\n", argv[i]);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "4") == 0) {
+                moves = MOVES_4;
+            } else if (strcmp(argv[i], "8") == 0) {
+                moves = MOVES_8;
+            } else if (strcmp(argv[i], "8-no-corners") == 0) {
+                moves = MOVES_8_NO_CORNERS;
+            } else {
+                printf("Unknown moves '%s' (expected 4, 8 or 8-no-corners). Exiting...\n",
+                    argv[i]);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--jps") == 0) {
+            jps = 1;
+        } else if (strcmp(argv[i], "--bidir") == 0) {
+            bidirectional = 1;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            query_file = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--landmarks") == 0 && i + 1 < argc) {
+            landmark_file = argv[++i];
+        } else if (strcmp(argv[i], "--make-landmarks") == 0 && i + 2 < argc) {
+            num_landmarks = atoi(argv[++i]);
+            landmark_file = argv[++i];
+        } else if (strcmp(argv[i], "--flow") == 0 && i + 1 < argc) {
+            flow_file = argv[++i];
+        } else if (strcmp(argv[i], "--make-flow") == 0 && i + 1 < argc) {
+            flow_file = argv[++i];
+            make_flow = 1;
+        } else if (strcmp(argv[i], "--ara") == 0 && i + 1 < argc) {
+            ara.budget = atof(argv[++i]);
+            if (ara.budget < 0) {
+                printf("The time budget of --ara can't be negative. Exiting...\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--epsilon") == 0 && i + 1 < argc) {
+            ara.epsilon = (int) (atof(argv[++i]) * ARA_EPSILON_SCALE + 0.5);
+            if (ara.epsilon < ARA_EPSILON_SCALE) {
+                printf("--epsilon must be at least 1. Exiting...\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--epsilon-step") == 0 && i + 1 < argc) {
+            ara.epsilon_step = (int) (atof(argv[++i]) * ARA_EPSILON_SCALE + 0.5);
+            if (ara.epsilon_step <= 0) {
+                printf("--epsilon-step must be positive. Exiting...\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--replan") == 0 && i + 1 < argc) {
+            change_file = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            print_report = 1;
+        } else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc) {
+            binary_file = argv[++i];
+        } else if (strcmp(argv[i], "--hpa") == 0 && i + 1 < argc) {
+            cluster_size = atoi(argv[++i]);
+            if (cluster_size <= 0) {
+                printf("The cluster size of --hpa must be positive. Exiting...\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--hda") == 0 && i + 1 < argc) {
+            hda_threads = atoi(argv[++i]);
+            if (hda_threads <= 0) {
+                printf("The number of threads of --hda must be positive. Exiting...\n");
+                return 0;
+            }
+        } else {
+            map_name = argv[i];
+            map_names[num_maps++] = argv[i];
+        }
+    }
+
     // Ensure a map is provided as a command line argument.
-    if (argc != 2) {
+    if (map_name == NULL) {
         printf("No argument given. Exiting...\n");
         return 0;
     }
 
-    Heap open_nodes;
+    if (jps && bidirectional) {
+        printf("--jps and --bidir can't be used together. Exiting...\n");
+        return 0;
+    }
+
+#ifdef MOVES
+    if (moves != -1 && moves != MOVES) {
+        printf("This build only has the moves it was built with (MOVES). Exiting...\n");
+        return 0;
+    }
+    moves = MOVES;
+#endif
+    if (moves == -1) {
+        moves = MOVES_8;
+    }
+
+    if (socket_path != NULL) {
+        // Answer queries over every map given until stopped, instead of searching one map once.
+        if (jps || bidirectional || query_file != NULL || landmark_file != NULL || cluster_size ||
+            hda_threads || flow_file != NULL || ara.budget >= 0 || change_file != NULL ||
+            binary_file != NULL || print_report) {
+            printf("--serve can only be used together with --threads, --open-list and --moves. "
+                "Exiting...\n");
+            return 0;
+        }
+        return run_server(map_names, num_maps, socket_path, num_threads, backend, moves);
+    }
+
+    if (moves != MOVES_8 && (jps || cluster_size || change_file != NULL)) {
+        printf("--jps, --hpa and --replan only move with --moves 8. Exiting...\n");
+        return 0;
+    }
+
+    if (cluster_size && (jps || bidirectional || landmark_file != NULL)) {
+        printf("--hpa can't be used together with --jps, --bidir or landmarks. Exiting...\n");
+        return 0;
+    }
+
+    if (hda_threads && (jps || bidirectional || landmark_file != NULL || cluster_size)) {
+        printf("--hda can't be used together with --jps, --bidir, landmarks or --hpa. "
+            "Exiting...\n");
+        return 0;
+    }
+
+    if (flow_file != NULL && (jps || bidirectional || landmark_file != NULL || cluster_size ||
+        hda_threads)) {
+        printf("--flow can't be used together with --jps, --bidir, landmarks, --hpa or --hda. "
+            "Exiting...\n");
+        return 0;
+    }
+
+    if (ara.budget >= 0 && (jps || bidirectional || cluster_size || hda_threads ||
+        flow_file != NULL)) {
+        printf("--ara can't be used together with --jps, --bidir, --hpa, --hda or --flow. "
+            "Exiting...\n");
+        return 0;
+    }
+
+    if (change_file != NULL && (jps || bidirectional || landmark_file != NULL || cluster_size ||
+        hda_threads || flow_file != NULL || ara.budget >= 0 || query_file != NULL ||
+        print_report)) {
+        printf("--replan can only be used together with --open-list. Exiting...\n");
+        return 0;
+    }
+
+    Stats stats;
+    init_stats(&stats, map_name, cluster_size ? "hpa" : hda_threads ? "hda" : flow_file ? "flow"
+        : (ara.budget >= 0) ? "ara" : jps ? "jps" : bidirectional ? "bidir" : "astar",
+        (ara.budget >= 0) ? BINARY_HEAP : backend, landmark_file != NULL);
+    double load_start = get_time();
+
+    Grid grid;
+    if (load_map(map_name, &grid) == -1) {
+        printf("Could not load map '%s'. Exiting...\n", map_name);
+        return 0;
+    }
 
-    open_nodes.curr_size = INIT_HEAP_SIZE;
-    open_nodes.nodes = malloc(open_nodes.curr_size * sizeof 
-        *(open_nodes.nodes) );
-    open_nodes.num_open_nodes = 0;
+    if (binary_file != NULL) {
+        // Only save the map in the binary format, to be loaded quickly later.
+        if (save_binary_map(&grid, binary_file) == -1) {
+            printf("Could not save the map to '%s'. Exiting...\n", binary_file);
+        } else {
+            printf("Saved the map to '%s'.\n", binary_file);
+        }
+        return 0;
+    }
 
-    grid = load_map(argv[1], &open_nodes);
-    //print_grid(grid);
+    label_components(&grid);
+    index_goals(&grid);
+    grid.moves = moves;
+    stats.num_rows = grid.num_rows;
+    stats.num_cols = grid.num_cols;
+    stats.moves = moves;
+    //print_grid(&search);
+
+    // uint32_t neighbors[NUM_SURR];
+    // int num_neighbors = get_neighbors(&search, 3 * grid.num_cols + 8, neighbors);
+    // print_node_list(&grid, neighbors, num_neighbors);
+
+    // Only plain A* searches for the nearest of many ends. Batch queries each have their own end.
+    if (grid.goals.num_goals > 1 && query_file == NULL && !num_landmarks &&
+        (jps || bidirectional || landmark_file != NULL || cluster_size || hda_threads ||
+        flow_file != NULL || ara.budget >= 0 || change_file != NULL)) {
+        printf("Maps with more than one end can only be searched with --open-list and --moves. "
+            "Exiting...\n");
+        return 0;
+    }
 
-    // Node** neighbors = get_neighbors(grid, grid[3][8]);
-    // print_node_list(neighbors, grid[3][8]->num_neighbors);
+    if (change_file != NULL) {
+        // Follow the map's path while its cells change, replanning after each batch of changes.
+        return run_replan(&grid, backend, change_file);
+    }
 
-    // analyze_step(grid, start_node);
+    if (num_landmarks) {
+        // Only pick the map's landmarks and save their distances for later searches.
+        num_landmarks = make_landmarks(&grid, num_landmarks, landmark_file);
+        if (num_landmarks == -1) {
+            printf("Could not save landmarks to '%s'. Exiting...\n", landmark_file);
+        } else {
+            printf("Saved %d landmarks to '%s'.\n", num_landmarks, landmark_file);
+        }
+        return 0;
+    }
+
+    if (make_flow) {
+        // Only flood the map from its end and save the flow field for later runs.
+        double start_time = get_time();
+        num_threads = make_flow_field(&grid, num_threads, flow_file);
+        if (num_threads == -1) {
+            printf("Could not save a flow field to '%s'. Exiting...\n", flow_file);
+        } else {
+            printf("Saved the flow field to '%s' (flooded in %.3f s on %d threads).\n",
+                flow_file, get_time() - start_time, num_threads);
+        }
+        return 0;
+    }
+
+    FlowField flow;
+    if (flow_file != NULL && load_flow_field(&flow, &grid, flow_file) == -1) {
+        printf("Could not load a flow field for this map from '%s'. Exiting...\n", flow_file);
+        return 0;
+    }
+    if (flow_file != NULL) {
+        grid.end_index = flow.end_index; // Every path leads to the field's end.
+    }
+
+    Landmarks landmarks;
+    if (landmark_file != NULL && load_landmarks(&landmarks, &grid, landmark_file) == -1) {
+        printf("Could not load landmarks for this map from '%s'. Exiting...\n", landmark_file);
+        return 0;
+    }
+
+    if (jps && grid.costs != NULL) {
+        printf("--jps only works on maps without terrain. Exiting...\n");
+        return 0;
+    }
+
+    JumpMap jump_map;
+    if (jps) {
+        load_jump_map(&grid, &jump_map);
+    }
+
+    Hpa hpa;
+    if (cluster_size) {
+        double start_time = get_time();
+        build_hpa(&hpa, &grid, cluster_size);
+        printf("# Abstract graph: %d clusters, %d nodes, %d edges, built in %.3f s\n",
+            hpa.num_cluster_rows * hpa.num_cluster_cols, hpa.num_nodes, hpa.num_edges,
+            get_time() - start_time);
+    }
+
+    Hda hda;
+    if (hda_threads) {
+        init_hda(&hda, &grid, hda_threads, backend);
+        stats.num_threads = hda_threads;
+    }
+    stats.load_time = get_time() - load_start;
+
+    if (query_file != NULL) {
+        // Answer every query in the file instead of finding the map's own path.
+        return run_batch(&grid, jps ? &jump_map : NULL, landmark_file ? &landmarks : NULL,
+            cluster_size ? &hpa : NULL, hda_threads ? &hda : NULL, flow_file ? &flow : NULL,
+            (ara.budget >= 0) ? &ara : NULL, backend, bidirectional, query_file, num_threads,
+            print_report ? &stats : NULL);
+    }
+
+    if (grid.start_index == NO_INDEX || grid.end_index == NO_INDEX) {
+        printf("The map needs a start and an end to find a path between. Exiting...\n");
+        return 0;
+    }
+
+    Search search;
+    init_search(&search, &grid, jps ? &jump_map : NULL, backend);
+    search.landmarks = landmark_file ? &landmarks : NULL;
 
     if (ANIMATE) {
         clear_screen();
     }
 
     // A STAR
-    int found = 0;
-    while (!found) {
-        found = analyze_step(grid, open_nodes.nodes[0], &open_nodes);
+    int path_cost;
+    Counts counts;
+    HpaSearch hpa_search;
+    AraSearch ara_search;
+    Search backward;
+    uint32_t meet_index;
+    double search_start = get_time();
+    if (cluster_size) {
+        init_hpa_search(&hpa_search, &hpa);
+        path_cost = find_hpa_path(&hpa_search, grid.start_index, grid.end_index);
+        get_hpa_counts(&hpa_search, &counts);
+    } else if (hda_threads) {
+        path_cost = find_hda_path(&hda, grid.start_index, grid.end_index);
+        get_hda_counts(&hda, &counts);
+    } else if (flow_file != NULL) {
+        path_cost = follow_flow_field(&flow, &grid, grid.start_index);
+        memset(&counts, 0, sizeof counts);
+    } else if (ara.budget >= 0) {
+        init_ara_search(&ara_search, &grid, search.landmarks, &ara);
+        path_cost = find_ara_path(&ara_search, grid.start_index, grid.end_index);
+        get_search_counts(&ara_search.search, &counts);
+    } else if (bidirectional) {
+        init_search(&backward, &grid, NULL, backend);
+        backward.landmarks = search.landmarks;
+        path_cost = find_bidirectional_path(&search, &backward, grid.start_index, grid.end_index,
+            &meet_index);
+        get_bidirectional_counts(&search, &backward, &counts);
+    } else {
+        if (grid.goals.num_goals > 1) {
+            search.goals = &grid.goals;
+            reset_search(&search, grid.start_index, NO_INDEX);
+        } else {
+            reset_search(&search, grid.start_index, grid.end_index);
+        }
+        path_cost = find_path(&search);
+        get_search_counts(&search, &counts);
+    }
+    stats.search_time = get_time() - search_start;
+    add_path(&stats, path_cost, &counts);
+
+    if (path_cost == -1) {
+        print_grid(&search);
+        printf("No path found!\n");
+        if (print_report) {
+            print_stats(&stats);
+        }
+        return 0;
     }
 
-    draw_path(grid, end_node);
+    double reconstruct_start = get_time();
+    if (cluster_size) {
+        // Chain the refined path's cells together in the search, so it can be drawn like any
+        // other path.
+        reset_search(&search, grid.start_index, grid.end_index);
+        for (int i = 1; i < hpa_search.path_len; i++) {
+            get_node(&search, hpa_search.path[i])->prev_index = hpa_search.path[i - 1];
+        }
+    } else if (hda_threads) {
+        // Likewise, with the path left in the HDA* search's nodes.
+        reset_search(&search, grid.start_index, grid.end_index);
+        for (uint32_t index = grid.end_index; index != grid.start_index;
+            index = hda.nodes[index].prev_index) {
+            get_node(&search, index)->prev_index = hda.nodes[index].prev_index;
+        }
+    } else if (flow_file != NULL) {
+        reset_search(&search, grid.start_index, grid.end_index);
+        for (uint32_t index = grid.start_index; index != grid.end_index;
+            index = get_flow_step(&flow, &grid, index)) {
+            get_node(&search, get_flow_step(&flow, &grid, index))->prev_index = index;
+        }
+    } else if (ara.budget >= 0) {
+        // Likewise, with the path left in the ARA* search's nodes.
+        reset_search(&search, grid.start_index, grid.end_index);
+        Node* nodes = ara_search.search.nodes;
+        for (uint32_t index = grid.end_index; index != grid.start_index;
+            index = nodes[index].prev_index) {
+            get_node(&search, index)->prev_index = nodes[index].prev_index;
+        }
+    } else if (bidirectional) {
+        join_paths(&search, &backward, meet_index);
+    }
+    trace_path(&search);
+    stats.reconstruct_time = get_time() - reconstruct_start;
+
+    print_grid(&search);
+    for (int i = 0; ara.budget >= 0 && i < ara_search.num_solutions; i++) {
+        AraSolution* solution = &ara_search.solutions[i];
+        printf("# Path cost %d, at most %.2f times the shortest (epsilon %.2f), after %" PRId64
+            " nodes expanded and %.3f s\n", solution->path_cost,
+            (double) solution->bound / ARA_EPSILON_SCALE,
+            (double) solution->epsilon / ARA_EPSILON_SCALE, solution->num_expanded,
+            solution->seconds);
+    }
     printf("Found!\n");
+    if (search.goals != NULL) {
+        printf("Nearest of %u ends: (%d, %d)\n", grid.goals.num_goals,
+            get_row(&grid, search.end_index), get_col(&grid, search.end_index));
+    }
+    printf("Path cost: %d | Nodes expanded: %" PRId64 " | Open list pushes: %" PRId64
+        " | Open list pops: %" PRId64 "\n", path_cost, counts.num_expanded, counts.num_pushes,
+        counts.num_pops);
+    if (print_report) {
+        print_stats(&stats);
+    }
 
     return 0;
 }
 
-Node*** load_map(char *map_name, Heap* open_nodes) {
+void init_search(Search* search, Grid* grid, JumpMap* jump_map, int backend) {
+    /* Allocates the search fields of every cell of the grid, and an empty open list. */
+
+    search->grid = grid;
+    search->jump_map = jump_map;
+    search->nodes = calloc(grid->num_cells, sizeof *(search->nodes));
+    search->generation = 0;
+    search->landmarks = NULL;
+    search->goals = NULL;
+    search->balanced = 0;
+    init_open_nodes(&search->open_nodes, backend);
+}
 
-    // Load in the map file.
-    FILE *fp = fopen(map_name, "r");
+void reset_search(Search* search, uint32_t start_index, uint32_t end_index) {
+    /* Prepares a search for a path from start_index to end_index and puts the start node on the
+    open list. Moving on to a new generation leaves every node untouched (see get_node), so this
+    doesn't depend on the size of the grid. */
 
-    // Read the map's dimensions.
-    fscanf(fp, "%dx%d\n\n", &NUM_ROWS, &NUM_COLS);
+    Grid* grid = search->grid;
 
-    // Allocate memory for the grid.
-    Node*** grid = malloc( NUM_ROWS * sizeof *(grid) );
-    for (int i = 0; i < NUM_ROWS; i++) {
-        grid[i] = malloc( NUM_COLS * sizeof *(grid[i]));
+    search->generation++;
+    if (search->generation == 0) {
+        // The stamps have wrapped around, so old stamps could match again. Clear them all once.
+        for (uint32_t i = 0; i < grid->num_cells; i++) {
+            search->nodes[i].generation = 0;
+        }
+        search->generation = 1;
     }
 
-    // Read in map character by character and save it into the grid.
-    char curr_char;
-    int row = 0, col = 0;
-    while ( (curr_char = getc(fp)) != EOF ) {
+    search->start_index = start_index;
+    search->end_index = end_index;
+    search->num_expanded = 0;
+    clear_open_nodes(&search->open_nodes);
+    search->num_reopened = 0;
+    search->num_decreased = 0;
+    search->open_nodes.num_pushes = 0;
+    search->open_nodes.num_pops = 0;
+    search->open_nodes.num_sift_levels = 0;
+    search->open_nodes.max_sift_depth = 0;
+    search->open_nodes.peak_open_nodes = 0;
+
+    Node* start_node = get_node(search, start_index);
+    start_node->g_cost = 0;
+    start_node->h_cost = get_heuristic(search, start_index);
+    start_node->f_cost = start_node->h_cost;
+    start_node->prev_index = start_index;
+    add_open_node(start_node, &search->open_nodes);
+}
+
+int find_path(Search* search) {
+    /* Runs A* until the end node is reached. Returns the cost of the path found, or -1 if the
+    open list runs out first (there is no path). */
 
-        if (curr_char == NEW_LINE) {
-            row++;
-            col = 0;
-            continue;
+    // Don't search the start's whole component for an end outside of it.
+    if (search->goals != NULL) {
+        if (!reaches_goal(search->grid, search->start_index)) {
+            return -1;
         }
+    } else if (search->end_index != NO_INDEX &&
+        !same_component(search->grid, search->start_index, search->end_index)) {
+        return -1;
+    }
 
-        // Create and allocate memory for a new node.
-        Node* new_node = malloc(sizeof *(new_node));
-        new_node->type = curr_char;
-        new_node->row  = row;
-        new_node->col  = col;
-
-        // Set the status of the node to open or not (implied closed).
-        if (new_node->type == EMPTY) {
-            new_node->is_open = 1;
-            new_node->analyzed_once = 0;
-            new_node->heap_index = -1;
-            new_node->prev_node = malloc(sizeof *(new_node->prev_node));
-        } else if (new_node->type == END) {
-            new_node->is_open = 1;
-            end_node = new_node;
-            new_node->analyzed_once = 0;
-            new_node->heap_index = -1;
-            new_node->prev_node = malloc(sizeof *(new_node->prev_node));
-        } else if (new_node->type == START) {
-            new_node->is_open = 1;
-            new_node->analyzed_once = 0;
-            new_node->heap_index = -1;
-            new_node->g_cost = 0;
-            add_open_node(new_node, open_nodes);
-        } else if (new_node->type == OBSTACLE) {
-            new_node->is_open = 0;
+    int found = 0;
+    while (!found) {
+        if (search->jump_map != NULL) {
+            found = analyze_jump_step(search);
+        } else {
+            found = analyze_step(search);
         }
+    }
+
+    return (found == 1) ? search->nodes[search->end_index].g_cost : -1;
+}
 
-        grid[row][col] = new_node;
-        if (DEBUG >= 3) printf("Saved %c\n", grid[row][col]->type);
+Node* get_node(Search* search, uint32_t index) {
+    /* Returns the node of a cell in the current search. The first time a node is asked for in a
+    search, its fields are reset: open (or closed if it's an obstacle) and unanalyzed. */
 
-        col++;  
+    Node* node = &search->nodes[index];
+    if (node->generation != search->generation) {
+        node->generation = search->generation;
+        node->is_open = !is_obstacle(search->grid, index);
+        node->analyzed_once = 0;
+        node->heap_index = -1;
     }
 
-    if (DEBUG >= 2) printf("load_map function finished.\n");
-    return grid;
+    return node;
 }
 
-Node** get_neighbors(Node*** grid, Node* node) {
-    /* Returns an array of pointers to neighboring open nodes of the 
-    given node. */
+int get_neighbors(Search* search, uint32_t index, uint32_t* neighbors) {
+    /* Saves the cell indices of the open neighbors of a node that the grid's moves can step to
+    into neighbors (which must have room for NUM_SURR), row by row, and returns how many
+    there are. */
+
+    int num_neighbors = pick_neighbors(search->grid, search, index, neighbors);
+    if (DEBUG == 2) printf("num_neighbors: %d\n", num_neighbors);
+    return num_neighbors;
+}
 
-    int counter = 0;
-    Node** neighbors = malloc(NUM_SURR * sizeof *(neighbors));
+int get_open_neighbors(Grid* grid, uint32_t index, uint32_t* neighbors) {
+    // Like get_neighbors, for every open cell next to a cell, whether or not any search closed it.
+    return pick_neighbors(grid, NULL, index, neighbors);
+}
 
-    for (int row = node->row - 1; row <= node->row + 1; row++) {
-        for (int col = node->col - 1; col <= node->col + 1; col++) {
+static ALWAYS_INLINE int pick_neighbors(Grid* grid, Search* search, uint32_t index,
+    uint32_t* neighbors) {
+    /* Each kind of move has its own copy of find_neighbors, with the moves fixed, so choosing
+    between them costs one branch per node rather than one per neighbor. */
+#ifdef MOVES
+    return find_neighbors(grid, search, index, neighbors, MOVES);
+#else
+    if (grid->moves == MOVES_8) {
+        return find_neighbors(grid, search, index, neighbors, MOVES_8);
+    } else if (grid->moves == MOVES_4) {
+        return find_neighbors(grid, search, index, neighbors, MOVES_4);
+    }
+    return find_neighbors(grid, search, index, neighbors, MOVES_8_NO_CORNERS);
+#endif
+}
+
+static ALWAYS_INLINE int find_neighbors(Grid* grid, Search* search, uint32_t index,
+    uint32_t* neighbors, int moves) {
+    /* Finds the neighbors of a cell for one kind of move, skipping those search has closed (if
+    search isn't NULL). Cells away from the edges of the map have all 8 neighbors on the map, so
+    they are found by fixed steps from the index (see step_index) with no bounds checks, and only
+    cells on the edges go through find_edge_neighbors. */
+
+#if LAYOUT == LAYOUT_TILED
+    int row = get_row(grid, index), col = get_col(grid, index);
+#else
+    int row = get_row(grid, index), col = index - (uint32_t) row * grid->num_cols;
+#endif
+    if (row == 0 || col == 0 || row == grid->num_rows - 1 || col == grid->num_cols - 1) {
+        return find_edge_neighbors(grid, search, index, neighbors, moves);
+    }
 
-            if ( (row == node->row && col == node->col) ||
-                row < 0 || row >= NUM_ROWS ||
-                col < 0 || col >= NUM_COLS ||
-                !grid[row][col]->is_open) {
+    uint32_t up = step_index(grid, index, -1, 0), down = step_index(grid, index, 1, 0);
+    uint32_t left = step_index(grid, index, 0, -1), right = step_index(grid, index, 0, 1);
+    int up_open = !is_obstacle(grid, up), down_open = !is_obstacle(grid, down);
+    int left_open = !is_obstacle(grid, left), right_open = !is_obstacle(grid, right);
+    int corners = (moves == MOVES_8);
+    int n = 0;
+
+    if (moves != MOVES_4 && (corners || (up_open && left_open)) &&
+        is_reachable(grid, search, step_index(grid, up, 0, -1))) {
+        neighbors[n++] = step_index(grid, up, 0, -1);
+    }
+    if (up_open && (search == NULL || get_node(search, up)->is_open)) {
+        neighbors[n++] = up;
+    }
+    if (moves != MOVES_4 && (corners || (up_open && right_open)) &&
+        is_reachable(grid, search, step_index(grid, up, 0, 1))) {
+        neighbors[n++] = step_index(grid, up, 0, 1);
+    }
+    if (left_open && (search == NULL || get_node(search, left)->is_open)) {
+        neighbors[n++] = left;
+    }
+    if (right_open && (search == NULL || get_node(search, right)->is_open)) {
+        neighbors[n++] = right;
+    }
+    if (moves != MOVES_4 && (corners || (down_open && left_open)) &&
+        is_reachable(grid, search, step_index(grid, down, 0, -1))) {
+        neighbors[n++] = step_index(grid, down, 0, -1);
+    }
+    if (down_open && (search == NULL || get_node(search, down)->is_open)) {
+        neighbors[n++] = down;
+    }
+    if (moves != MOVES_4 && (corners || (down_open && right_open)) &&
+        is_reachable(grid, search, step_index(grid, down, 0, 1))) {
+        neighbors[n++] = step_index(grid, down, 0, 1);
+    }
+
+    return n;
+}
+
+int find_edge_neighbors(Grid* grid, Search* search, uint32_t index, uint32_t* neighbors,
+    int moves) {
+    // find_neighbors for a cell on an edge of the map, checking that each neighbor is on it.
+
+    int node_row = get_row(grid, index);
+    int node_col = get_col(grid, index);
+    int n = 0;
+
+    for (int row = node_row - 1; row <= node_row + 1; row++) {
+        for (int col = node_col - 1; col <= node_col + 1; col++) {
+            int diagonal = (row != node_row && col != node_col);
+            if ((row == node_row && col == node_col) || row < 0 || row >= grid->num_rows ||
+                col < 0 || col >= grid->num_cols || (diagonal && moves == MOVES_4)) {
+                continue;
+            }
+
+            // Both cells beside a diagonal step are on the map if the step's end is.
+            if (diagonal && moves == MOVES_8_NO_CORNERS &&
+                (is_obstacle(grid, get_index(grid, node_row, col)) ||
+                is_obstacle(grid, get_index(grid, row, node_col)))) {
                 continue;
             }
 
-            neighbors[counter++] = grid[row][col];
+            uint32_t next_index = get_index(grid, row, col);
+            if (is_reachable(grid, search, next_index)) {
+                neighbors[n++] = next_index;
+            }
         }
     }
 
-    node->num_neighbors = counter;
-    if (DEBUG == 2) printf("num_neighbors: %d\n", node->num_neighbors);
-    return neighbors;
+    return n;
+}
+
+static ALWAYS_INLINE int is_reachable(Grid* grid, Search* search, uint32_t index) {
+    // Returns whether a cell is open space whose node search (if any) hasn't closed.
+    return !is_obstacle(grid, index) && (search == NULL || get_node(search, index)->is_open);
 }
 
-int analyze_step(Node*** grid, Node* node, Heap* open_nodes) {
-    // TODO IMPLEMENT HEAP
+int analyze_step(Search* search) {
+    /* Takes the open node with the lowest f_cost off the open list, closes it, and analyzes each
+    of its open neighbors. Returns 1 once the end node is reached, or -1 if the open list is
+    empty. */
 
-    if (DEBUG) printf("New step: (%d, %d)\n", node->row, node->col);
+    Node* node = pop_open_node(&search->open_nodes);
+    if (node == NULL) {
+        return -1;
+    }
+
+    Grid* grid = search->grid;
+    uint32_t index = node_index(search, node);
+    if (DEBUG) printf("New step: (%d, %d)\n", get_row(grid, index), get_col(grid, index));
     
     node->is_open = 0;
+    search->num_expanded++;
+
+    // The path to a node is only known to be the shortest once it is taken off the open list, so
+    // the search ends when the end node is, not when it is first reached. Searching for the
+    // nearest of many ends, the first end taken off is the nearest, and becomes the search's end.
+    if (index == search->end_index) {
+        return 1;
+    } else if (search->goals != NULL && is_goal(search->goals, index)) {
+        search->end_index = index;
+        return 1;
+    }
+
+    uint32_t neighbors[NUM_SURR];
+    int num_neighbors = get_neighbors(search, index, neighbors);
 
-    pop_root(open_nodes->nodes, (open_nodes->num_open_nodes)--, cmp);
+    for (int i = 0; i < num_neighbors; i++) {
+        visit_node(search, neighbors[i], index);
+    }
 
-    int found;
-    Node** neighbors = get_neighbors(grid, node);
+    if (ANIMATE == 2) {
+        clear_screen();
+        print_grid(search);
+    }
 
-    for (int i = 0; i < node->num_neighbors; i++) {
-        found = analyze_node(neighbors[i], node);
+    return 0;
+}
 
-        if (found) {
-            end_node = neighbors[i];
-            return 1;
-        }
+int analyze_jump_step(Search* search) {
+    /* Like analyze_step, but instead of analyzing every neighbor of the node, jumps from it in
+    each direction the path through it could continue (see jps.h) and analyzes the jump points
+    found. Returns 1 once the end node is reached, or -1 if the open list is empty. */
 
-        if (!neighbors[i]->analyzed_once) {
-            add_open_node(neighbors[i], open_nodes);
-            neighbors[i]->analyzed_once = 1;
+    Node* node = pop_open_node(&search->open_nodes);
+    if (node == NULL) {
+        return -1;
+    }
+
+    Grid* grid = search->grid;
+    JumpMap* jump_map = search->jump_map;
+    uint32_t index = node_index(search, node);
+    if (DEBUG) printf("New jump step: (%d, %d)\n", get_row(grid, index), get_col(grid, index));
+
+    node->is_open = 0;
+    search->num_expanded++;
+
+    if (index == search->end_index) {
+        return 1;
+    }
+
+    // Get the direction the node was reached in. The start node is its own parent.
+    int row = get_row(grid, index), col = get_col(grid, index);
+    int dx = num_sign(col - get_col(grid, node->prev_index));
+    int dy = num_sign(row - get_row(grid, node->prev_index));
+
+    int dirs[NUM_SURR][2];
+    int num_dirs = get_jump_dirs(jump_map, row, col, dx, dy, dirs);
+    int end_row = get_row(grid, search->end_index);
+    int end_col = get_col(grid, search->end_index);
+
+    for (int i = 0; i < num_dirs; i++) {
+        int jump_row = row, jump_col = col;
+
+        if (dirs[i][0] && dirs[i][1]) {
+            if (!jump_diagonal(jump_map, &jump_row, &jump_col, dirs[i][0], dirs[i][1], end_row,
+                end_col)) {
+                continue;
+            }
+        } else if (dirs[i][0]) {
+            jump_col = jump_straight(&jump_map->rows, row, col, dirs[i][0], end_row,
+                end_col);
         } else {
-            int parent_index = get_parent_index(neighbors[i]->heap_index);
-            check_node(open_nodes->nodes, open_nodes->num_open_nodes, parent_index, cmp);
+            jump_row = jump_straight(&jump_map->cols, col, row, dirs[i][1], end_col,
+                end_row);
+        }
+
+        if (jump_row == -1 || jump_col == -1) {
+            continue;
+        }
+
+        uint32_t jump_index = get_index(grid, jump_row, jump_col);
+        if (get_node(search, jump_index)->is_open) {
+            visit_node(search, jump_index, index);
         }
     }
 
     if (ANIMATE == 2) {
         clear_screen();
-        print_grid(grid);
+        print_grid(search);
     }
 
     return 0;
 }
 
-int analyze_node(Node* next_node, Node* curr_node) {
-    /* Given a node "next_node", analyzes and updates its g_cost, h_cost, and f_cost. */
+int visit_node(Search* search, uint32_t next_index, uint32_t curr_index) {
+    /* Analyzes an open node reached from curr_node, then adds it to the open list if it is new
+    or restores the open list's order if a shorter path to it was found. Returns 1 if the node
+    got a shorter path, or 0 if not. */
 
-    int g_cost = get_distance(next_node, curr_node) + curr_node->g_cost;
+    Node* next_node = get_node(search, next_index);
+    int old_f_cost = next_node->f_cost;
+
+    if (!analyze_node(search, next_index, curr_index)) {
+        return 0;
+    }
+
+    if (!next_node->analyzed_once) {
+        add_open_node(next_node, &search->open_nodes);
+        next_node->analyzed_once = 1;
+    } else {
+        // A shorter path to a node already on the open list was found.
+        update_open_node(next_node, old_f_cost, &search->open_nodes);
+    }
+
+    return 1;
+}
+
+int analyze_node(Search* search, uint32_t next_index, uint32_t curr_index) {
+    /* Given the index of a node "next_node", analyzes and updates its g_cost, h_cost, and
+    f_cost. Returns 1 if the node's costs were set, or 0 if it already has a path at least as
+    short. */
+
+    Grid* grid = search->grid;
+    Node* next_node = get_node(search, next_index);
+    Node* curr_node = get_node(search, curr_index);
+    int g_cost = get_step_cost(grid, next_index, curr_index) + curr_node->g_cost;
 
     if (next_node->analyzed_once) {
         // If the node has already been analyzed, then h_cost will not change.
         // Just check if g_cost is lower, and if so, update it and f_cost.
         if (g_cost < next_node->g_cost) {
+            if (next_node->is_open) {
+                search->num_decreased++;
+            } else {
+                search->num_reopened++;
+            }
             next_node->g_cost = g_cost;
             next_node->f_cost = next_node->g_cost + next_node->h_cost;
-            next_node->prev_node = curr_node;
+            next_node->prev_index = curr_index;
             if (DEBUG) {
-                printf("New path defined: (%d, %d) -> (%d, %d)\n", next_node->prev_node->row, 
-                    next_node->prev_node->col, next_node->row, next_node->col);
+                printf("New path defined: (%d, %d) -> (%d, %d)\n", get_row(grid, curr_index),
+                    get_col(grid, curr_index), get_row(grid, next_index),
+                    get_col(grid, next_index));
             }
         } else {
             return 0;
         }
     } else {
         next_node->g_cost = g_cost;
-        next_node->h_cost = get_distance(next_node, end_node);
+        next_node->h_cost = get_heuristic(search, next_index);
         next_node->f_cost = next_node->g_cost + next_node->h_cost;
 
-        next_node->prev_node = curr_node;
+        next_node->prev_index = curr_index;
         if (DEBUG) {
-            printf("New path defined: (%d, %d) -> (%d, %d)*\n", next_node->prev_node->row, 
-                next_node->prev_node->col, next_node->row, next_node->col);
+            printf("New path defined: (%d, %d) -> (%d, %d)*\n", get_row(grid, curr_index),
+                get_col(grid, curr_index), get_row(grid, next_index),
+                get_col(grid, next_index));
         }
     }
 
     if (DEBUG) {
-        printf("(%d, %d): g_cost %d | h_cost %d | f_cost %d\n", next_node->row, 
-            next_node->col, next_node->g_cost, next_node->h_cost, next_node->f_cost);
+        printf("(%d, %d): g_cost %d | h_cost %d | f_cost %d\n", get_row(grid, next_index),
+            get_col(grid, next_index), next_node->g_cost, next_node->h_cost, next_node->f_cost);
     }
 
     if (ANIMATE == 3) {
         clear_screen();
-        print_grid(grid);
+        print_grid(search);
+    }
+
+    return 1;
+}
+
+int get_heuristic(Search* search, uint32_t index) {
+    /* Returns the h_cost of a node: the octile distance to the end node (times the cheapest
+    terrain cost), or the landmarks' bound on it if that is larger. Each side of a bidirectional
+    search instead uses half the difference between its distance to the end and its distance to
+    the start, rounded down. Rounding down keeps the heuristic consistent when the difference is
+    odd (landmark distances over terrain can be), and makes the two sides' heuristics add up to 0
+    or -1, never more, which is all the stopping rule in bidir.h needs. A search for the nearest of
+    many ends uses the distance to the nearest one (see goals.h), and a search with no end node
+    floods the map, with no h_cost. */
+
+    if (search->goals != NULL) {
+        return get_goal_distance(search->grid, search->goals, index);
+    } else if (search->end_index == NO_INDEX) {
+        return 0;
+    }
+
+    int h_cost = get_estimate(search, index, search->end_index);
+    if (search->balanced) {
+        int difference = h_cost - get_estimate(search, index, search->start_index);
+        h_cost = (difference - (difference < 0)) / 2;
     }
 
-    return (next_node->type == END);
+    return h_cost;
+}
+
+int get_estimate(Search* search, uint32_t index1, uint32_t index2) {
+    // Returns a lower bound on the length of the shortest path between two cells.
+    int estimate = get_min_distance(search->grid, index1, index2);
+    if (search->landmarks != NULL) {
+        int bound = get_landmark_bound(search->landmarks, index1, index2);
+        if (bound > estimate) {
+            estimate = bound;
+        }
+    }
+    return estimate;
 }
 
-int get_distance(Node* node1, Node* node2) {
+int get_distance(Grid* grid, uint32_t index1, uint32_t index2) {
 
-    int dx = abs(node1->col - node2->col);
-    int dy = abs(node1->row - node2->row);
+    /* Returns the length of the shortest path between two cells on an open map: the octile
+    distance, or the Manhattan distance when only moving straight. */
 
+#if LAYOUT == LAYOUT_TILED
+    int dx = abs(get_col(grid, index1) - get_col(grid, index2));
+    int dy = abs(get_row(grid, index1) - get_row(grid, index2));
+#else
+    // One division per cell: the column is what's left of the index after the row.
+    int row1 = get_row(grid, index1), row2 = get_row(grid, index2);
+    int dx = abs((int) (index1 - (uint32_t) row1 * grid->num_cols) -
+        (int) (index2 - (uint32_t) row2 * grid->num_cols));
+    int dy = abs(row1 - row2);
+#endif
+
+    if (grid->moves == MOVES_4) {
+        return (dx + dy) * PRECISION_MULT;
+    }
     return num_min(dx, dy) * SQRT_2 + abs(dx - dy) * PRECISION_MULT;
 }
 
-int num_min(int a, int b) {
-    return (a < b) ? a : b;
+int get_min_distance(Grid* grid, uint32_t index1, uint32_t index2) {
+    /* Returns the octile distance between two cells as if every cell on the way had the cheapest
+    terrain of the map, which no path between them can cost less than. */
+    return get_distance(grid, index1, index2) * grid->min_cost;
 }
 
-int cmp(Node* a, Node* b) {
-    if (DEBUG_H) printf("Minning %d and %d -> %d\n", a->f_cost, b->f_cost, (a->f_cost < b->f_cost));
-    if (a->f_cost == b->f_cost) {
-        return (a->h_cost < b->h_cost);
-    } else {
-        return (a->f_cost < b->f_cost);
+int get_step_cost(Grid* grid, uint32_t index1, uint32_t index2) {
+    /* Returns the cost of a single step between two neighboring cells. On maps with terrain, half
+    of the step is in each cell, so its length is weighted by the average of their costs. Steps are
+    PRECISION_MULT or SQRT_2 long, both even, so the half is exact, and a step costs the same in
+    both directions. */
+
+    int cost = get_distance(grid, index1, index2);
+    if (grid->costs != NULL) {
+        cost = cost / 2 * (grid->costs[index1] + grid->costs[index2]);
     }
+    return cost;
 }
 
-// int max(Node a, Node b) {
-//     if (DEBUG_H) printf("Maxing %d and %d -> %d\n", a.f_cost, b.f_cost, (a.f_cost > b.f_cost));
-//     return (a.f_cost > b.f_cost);
-// }
+uint32_t node_index(Search* search, Node* node) {
+    // Returns the cell index of a node, i.e. its position in the search's node array.
+    return (uint32_t) (node - search->nodes);
+}
+
+int num_min(int a, int b) {
+    return (a < b) ? a : b;
+}
+
+int num_sign(int a) {
+    return (a > 0) - (a < 0);
+}
 
-void print_grid(Node*** grid) {
-    for (int i = 0; i < NUM_ROWS; i++) {
-        for (int j = 0; j < NUM_COLS; j++) {
+void print_grid(Search* search) {
+    Grid* grid = search->grid;
+    for (int i = 0; i < grid->num_rows; i++) {
+        for (int j = 0; j < grid->num_cols; j++) {
+            char cell_type = get_cell_type(grid, get_index(grid, i, j));
+            Node* node = get_node(search, get_index(grid, i, j));
             if (ANIMATE) {
-                if (grid[i][j]->is_open && grid[i][j]->analyzed_once)
-                    printf(GREEN "%c", grid[i][j]->type);
-                else if (!grid[i][j]->is_open && grid[i][j]->analyzed_once)
-                    printf(RED "%c", grid[i][j]->type);
+                if (node->is_open && node->analyzed_once)
+                    printf(GREEN "%c", cell_type);
+                else if (!node->is_open && node->analyzed_once)
+                    printf(RED "%c", cell_type);
                 else
-                    printf(NORMAL "%c", grid[i][j]->type);
+                    printf(NORMAL "%c", cell_type);
             } else {
-                printf("%c", grid[i][j]->type);
+                printf("%c", cell_type);
             }
         }
         printf("\n");
     }
 }
 
-void print_node_list(Node** list, int len) {
+void print_node_list(Grid* grid, uint32_t* list, int len) {
     for (int i = 0; i < len; i++) {
-        printf("%c", list[i]->type);
+        printf("%c", get_cell_type(grid, list[i]));
     }
     printf("\n");
 }
 
+void init_open_nodes(Heap* open_nodes, int backend) {
+    /* Sets up an empty 'open' heap collection using the given backend. */
+
+    open_nodes->backend = backend;
+    open_nodes->curr_size = INIT_HEAP_SIZE;
+    open_nodes->nodes = malloc(open_nodes->curr_size * sizeof 
+        *(open_nodes->nodes) );
+    open_nodes->num_open_nodes = 0;
+    open_nodes->num_pushes = 0;
+    open_nodes->num_pops = 0;
+    open_nodes->num_sift_levels = 0;
+    open_nodes->max_sift_depth = 0;
+    open_nodes->peak_open_nodes = 0;
+    init_buckets(&open_nodes->buckets);
+}
+
+void clear_open_nodes(Heap* open_nodes) {
+    // Empties the 'open' heap collection, keeping its memory for the next search.
+    open_nodes->num_open_nodes = 0;
+    clear_buckets(&open_nodes->buckets);
+}
+
 void add_open_node(Node* node, Heap* open_nodes) {
     /* Adds a given node to the 'open' heap collection. */
 
-    open_nodes->num_open_nodes++;
-    if (open_nodes->num_open_nodes > open_nodes->curr_size) {
-        open_nodes->curr_size *= 2;
-        open_nodes->nodes = realloc(open_nodes->nodes, open_nodes->curr_size * 
-            sizeof *(open_nodes->nodes) );
+    open_nodes->num_pushes++;
+    if (open_nodes->backend == BUCKET_QUEUE) {
+        count_sift(open_nodes, push_bucket(&open_nodes->buckets, node));
+    } else {
+        open_nodes->num_open_nodes++;
+        if (open_nodes->num_open_nodes > open_nodes->curr_size) {
+            open_nodes->curr_size *= 2;
+            open_nodes->nodes = realloc(open_nodes->nodes, open_nodes->curr_size * 
+                sizeof *(open_nodes->nodes) );
+        }
+
+        count_sift(open_nodes, node_heap_push(node, open_nodes->nodes,
+            open_nodes->num_open_nodes));
     }
 
-    add_node(node, open_nodes->nodes, open_nodes->num_open_nodes, cmp);
+    if (count_open_nodes(open_nodes) > open_nodes->peak_open_nodes) {
+        open_nodes->peak_open_nodes = count_open_nodes(open_nodes);
+    }
 }
 
-void draw_path(Node*** grid, Node* end_node) {
+Node* pop_open_node(Heap* open_nodes) {
+    /* Removes and returns the node with the lowest f_cost from the 'open' heap collection.
+    Returns NULL if it is empty. */
 
-    Node* curr_node = end_node->prev_node;
-    while (curr_node->type != START) {
-        grid[curr_node->row][curr_node->col]->type = PATH_CHAR;
-        curr_node = curr_node->prev_node;
+    int num_levels;
+    Node* node;
+    if (open_nodes->backend == BUCKET_QUEUE) {
+        node = pop_bucket(&open_nodes->buckets, &num_levels);
+    } else if (open_nodes->num_open_nodes == 0) {
+        node = NULL;
+    } else {
+        node = node_heap_pop(open_nodes->nodes, (open_nodes->num_open_nodes)--, &num_levels);
     }
 
-    print_grid(grid);
+    if (node != NULL) {
+        open_nodes->num_pops++;
+        count_sift(open_nodes, num_levels);
+    }
+    return node;
+}
+
+Node* peek_open_node(Heap* open_nodes) {
+    /* Returns the node with the lowest f_cost in the 'open' heap collection without removing
+    it. Returns NULL if it is empty. */
+
+    if (open_nodes->backend == BUCKET_QUEUE) {
+        return peek_bucket(&open_nodes->buckets);
+    }
+
+    return (open_nodes->num_open_nodes) ? open_nodes->nodes[0] : NULL;
+}
+
+int count_open_nodes(Heap* open_nodes) {
+    // Returns the number of nodes in the 'open' heap collection.
+    if (open_nodes->backend == BUCKET_QUEUE) {
+        return open_nodes->buckets.num_nodes;
+    }
+    return open_nodes->num_open_nodes;
+}
+
+void update_open_node(Node* node, int old_f_cost, Heap* open_nodes) {
+    /* Restores the order of the 'open' heap collection after the f_cost of a node in it has been
+    lowered from old_f_cost. */
+
+    if (open_nodes->backend == BUCKET_QUEUE) {
+        count_sift(open_nodes, update_bucket(&open_nodes->buckets, node, old_f_cost));
+        return;
+    }
+
+    count_sift(open_nodes, node_heap_sift_up(open_nodes->nodes, node->heap_index));
+}
+
+void count_sift(Heap* open_nodes, int num_levels) {
+    // Adds the levels a node moved in one push, pop or update to the open list's counts.
+    open_nodes->num_sift_levels += num_levels;
+    if (num_levels > open_nodes->max_sift_depth) {
+        open_nodes->max_sift_depth = num_levels;
+    }
+}
+
+void free_search(Search* search) {
+    free(search->nodes);
+    free(search->open_nodes.nodes);
+    free_buckets(&search->open_nodes.buckets);
+}
+
+void draw_path(Search* search) {
+    // Marks the path found by the search on the map and prints it.
+    trace_path(search);
+    print_grid(search);
+}
+
+void trace_path(Search* search) {
+    /* Follows the path found by the search back from the end to the start, marking its cells on
+    the map. */
+
+    Grid* grid = search->grid;
+    uint32_t curr_index = search->end_index;
+    while (curr_index != search->start_index) {
+        // Nodes found by jump point search can be a straight or diagonal line apart from the
+        // node they were reached from, so step along the line back to it.
+        uint32_t prev_index = search->nodes[curr_index].prev_index;
+        int row = get_row(grid, curr_index), col = get_col(grid, curr_index);
+        int dy = num_sign(get_row(grid, prev_index) - row);
+        int dx = num_sign(get_col(grid, prev_index) - col);
+
+        uint32_t index;
+        do {
+            row += dy;
+            col += dx;
+            index = get_index(grid, row, col);
+            if (index != search->start_index) {
+                mark_path(grid, index);
+            }
+        } while (index != prev_index);
+
+        curr_index = prev_index;
+    }
+}
+
+void load_jump_map(Grid* grid, JumpMap* jump_map) {
+    // Builds the obstacle bitmaps used by jump point search from the grid.
+    init_jump_map(jump_map, grid->num_rows, grid->num_cols);
+    for (int i = 0; i < grid->num_rows; i++) {
+        for (int j = 0; j < grid->num_cols; j++) {
+            if (!is_obstacle(grid, get_index(grid, i, j))) {
+                set_free(jump_map, i, j);
+            }
+        }
+    }
 }
 
 void clear_screen() {
@@ -0,0 +1,603 @@
+// Loading and saving maps, and reading the cells of a loaded one.
+//
+// Text maps are an "RxC" header, a blank line and R rows of C characters ('_', 'Z', 'S' or 'E').
+// The file is mapped into memory and each row is checked and packed 8 characters at a time.
+//
+// Terrain: the digits '1' to '9' are open cells that cost that many times as much to cross as
+// '_' (which is the same as '1'). A map with any digit above '1' keeps a byte per cell with its
+// cost, and every step is weighted by the costs of the two cells it joins (see get_step_cost).
+// Costs stay small integers, so paths still cost whole numbers and the bucket queue still works.
+//
+// A map can have any number of 'E' cells. Searches for the map's own path then look for the
+// nearest of them (see goals.h), while end_index stays the last one, for every other use.
+//
+// Binary maps (made with --convert) are a MapHeader followed by the grid's obstacle bitmap, one
+// bit per cell in the order of cell indices, then the cost byte of each cell if the map has
+// terrain, and last the cell index of every end if it has more than one. The bitmap and costs are
+// used straight from the mapped file, so a binary map of any size loads in the time it takes to
+// map it, and takes 1 bit per cell (9 with terrain). The mapping is private: changing cells (see
+// dstar.h) never writes back to the file.
+//
+// Layout: cells are numbered row by row (row * num_cols + col), so the cells above and below a
+// cell are a whole row of nodes away from it, which on a wide map means another cache line and
+// often another page for each. Built with -DLAYOUT=LAYOUT_TILED, they are numbered in 8x8 tiles
+// instead: the 64 cells of a tile take up one word of the bitmap and 64 consecutive nodes, and
+// each cell's 8 neighbors are in its own tile or the next one over, wherever it is on the map.
+// The last row and column of tiles are padded with obstacles. Code that moves between cells
+// only goes through get_index, get_row, get_col and step_index, so it works with either layout.
+// Binary maps are always saved row by row, so they are copied into tiles when loaded by a tiled
+// build rather than used straight from the file, and files made from cell indices (landmarks and
+// flow fields) only fit builds with the same layout.
+
+#define MAP_MAGIC "AMAP"
+#define MAX_TERRAIN_COST 9
+
+// The header of a binary map. Its size is a multiple of 8 so the bitmap after it is aligned.
+typedef struct {
+    char magic[4];
+    int32_t num_rows;
+    int32_t num_cols;
+    uint32_t start_index; // NO_INDEX if the map has no start.
+    uint32_t end_index;   // NO_INDEX if the map has no end.
+    uint32_t min_cost;    // The grid's min_cost, or 0 if the map has no terrain.
+    uint32_t num_goals;   // The ends listed after the costs, or 0 if the map has fewer than 2.
+    uint32_t reserved;
+} MapHeader;
+
+// Function declarations --------------------------------------------------------------------------
+
+int load_map(char* map_name, Grid* grid);
+int load_text_map(char* text, size_t text_size, Grid* grid);
+int load_binary_map(Grid* grid);
+int set_num_cells(Grid* grid);
+void pad_tiles(Grid* grid);
+void copy_cells(Grid* grid, uint64_t* from_obstacles, uint8_t* from_costs, uint64_t* to_obstacles,
+    uint8_t* to_costs, int to_tiles);
+int parse_number(char** text, char* end);
+int read_row(Grid* grid, char* line, int row);
+int read_cells(Grid* grid, char* line, int row, int col, int end_col);
+uint64_t match_bytes(uint64_t word, char c);
+void set_cost(Grid* grid, uint32_t index, int cost);
+void add_goal(Grid* grid, int row, int col);
+void find_min_cost(Grid* grid);
+int save_binary_map(Grid* grid, char* file_name);
+size_t get_bitmap_words(Grid* grid);
+int is_obstacle(Grid* grid, uint32_t index);
+void set_cell(Grid* grid, uint32_t index, char type);
+uint32_t get_index(Grid* grid, int row, int col);
+int get_row(Grid* grid, uint32_t index);
+int get_col(Grid* grid, uint32_t index);
+static ALWAYS_INLINE uint32_t step_index(Grid* grid, uint32_t index, int dy, int dx);
+char get_cell_type(Grid* grid, uint32_t index);
+void mark_path(Grid* grid, uint32_t index);
+void free_map(Grid* grid);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int load_map(char* map_name, Grid* grid) {
+    /* Loads a text or binary map into grid. Returns 0, or -1 (after printing why) if the file
+    can't be read or isn't a valid map. */
+
+    grid->obstacles = NULL;
+    grid->costs = NULL;
+    grid->min_cost = 1;
+    grid->moves = MOVES_8;
+    grid->path = NULL;
+    grid->file = NULL;
+    grid->file_size = 0;
+    memset(&grid->goals, 0, sizeof grid->goals);
+
+    int fd = open(map_name, O_RDONLY);
+    struct stat file_stat;
+    if (fd == -1 || fstat(fd, &file_stat) == -1 || file_stat.st_size == 0) {
+        printf("Could not read map '%s'.\n", map_name);
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size_t file_size = file_stat.st_size;
+    char* file = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        printf("Could not map '%s' into memory.\n", map_name);
+        return -1;
+    }
+
+    if (file_size >= sizeof(MapHeader) && memcmp(file, MAP_MAGIC, strlen(MAP_MAGIC)) == 0) {
+        grid->file = file;
+        grid->file_size = file_size;
+        if (load_binary_map(grid) == -1) {
+            printf("'%s' is not a valid binary map.\n", map_name);
+            free_map(grid);
+            return -1;
+        }
+        return 0;
+    }
+
+    // The text is only needed until it's packed into the bitmap.
+    int result = load_text_map(file, file_size, grid);
+    munmap(file, file_size);
+    if (result == -1) {
+        free_map(grid);
+    }
+    return result;
+}
+
+int load_text_map(char* text, size_t text_size, Grid* grid) {
+    /* Reads a text map, checking that it has exactly the rows and columns its header says and no
+    other characters than those of the map format. */
+
+    char* end = text + text_size;
+    char* p = text;
+
+    grid->num_rows = parse_number(&p, end);
+    if (grid->num_rows <= 0 || p == end || *p++ != 'x') {
+        printf("The map's header should be 'ROWSxCOLS'.\n");
+        return -1;
+    }
+    grid->num_cols = parse_number(&p, end);
+    if (grid->num_cols <= 0 || set_num_cells(grid) == -1) {
+        printf("The map's header should be 'ROWSxCOLS', with fewer than 2^32 cells.\n");
+        return -1;
+    }
+
+    grid->start_index = grid->end_index = NO_INDEX;
+    grid->obstacles = calloc(get_bitmap_words(grid), sizeof *(grid->obstacles));
+    pad_tiles(grid);
+
+    // Blank lines between the header and the first row.
+    while (p < end && (*p == NEW_LINE || *p == '\r' || *p == ' ')) {
+        p++;
+    }
+
+    for (int row = 0; row < grid->num_rows; row++) {
+        if (end - p < grid->num_cols) {
+            printf("The map has %d rows, but its header says %d.\n", row, grid->num_rows);
+            return -1;
+        }
+        if (read_row(grid, p, row) == -1) {
+            return -1;
+        }
+        p += grid->num_cols;
+
+        // Each row ends with a new line (or the end of the file).
+        if (p < end && *p == '\r') {
+            p++;
+        }
+        if (p < end && *p != NEW_LINE) {
+            printf("Row %d of the map is longer than the header's %d columns.\n", row,
+                grid->num_cols);
+            return -1;
+        }
+        p++;
+    }
+
+    while (p < end && (*p == NEW_LINE || *p == '\r' || *p == ' ')) {
+        p++;
+    }
+    if (p < end) {
+        printf("The map has more rows than its header's %d.\n", grid->num_rows);
+        return -1;
+    }
+
+    if (grid->costs != NULL) {
+        find_min_cost(grid);
+    }
+    return 0;
+}
+
+int load_binary_map(Grid* grid) {
+    /* Points grid at the header, bitmap and costs of the mapped binary map in grid->file, after
+    checking that they fit together. A tiled build copies them into tiles instead. */
+
+    MapHeader* header = grid->file;
+    grid->num_rows = header->num_rows;
+    grid->num_cols = header->num_cols;
+    grid->start_index = header->start_index;
+    grid->end_index = header->end_index;
+
+    // The file's cells are always row by row.
+    uint64_t num_cells = (uint64_t) grid->num_rows * grid->num_cols;
+    size_t num_words = (num_cells + 63) / 64;
+    if (grid->num_rows <= 0 || grid->num_cols <= 0 || set_num_cells(grid) == -1 ||
+        (grid->start_index != NO_INDEX && grid->start_index >= num_cells) ||
+        (grid->end_index != NO_INDEX && grid->end_index >= num_cells) ||
+        header->min_cost > MAX_TERRAIN_COST ||
+        grid->file_size != sizeof *(header) + num_words * sizeof(uint64_t) +
+            (header->min_cost ? num_cells : 0) + header->num_goals * sizeof(uint32_t)) {
+        return -1;
+    }
+
+    uint64_t* obstacles = (uint64_t*) (header + 1);
+    uint8_t* costs = header->min_cost ? (uint8_t*) (obstacles + num_words) : NULL;
+    if (header->min_cost) {
+        grid->min_cost = header->min_cost;
+    }
+
+    uint32_t* goals = (uint32_t*) ((char*) (obstacles + num_words) +
+        (header->min_cost ? num_cells : 0));
+    for (uint32_t i = 0; i < header->num_goals; i++) {
+        uint32_t goal;
+        memcpy(&goal, &goals[i], sizeof goal); // After the costs, it may not be aligned.
+        if (goal >= num_cells) {
+            return -1;
+        }
+        add_goal(grid, goal / grid->num_cols, goal % grid->num_cols);
+    }
+    if (header->num_goals == 0 && grid->end_index != NO_INDEX) {
+        add_goal(grid, grid->end_index / grid->num_cols, grid->end_index % grid->num_cols);
+    }
+
+#if LAYOUT == LAYOUT_TILED
+    grid->obstacles = calloc(get_bitmap_words(grid), sizeof *(grid->obstacles));
+    grid->costs = (costs != NULL) ? malloc(grid->num_cells) : NULL;
+    copy_cells(grid, obstacles, costs, grid->obstacles, grid->costs, 1);
+    pad_tiles(grid);
+    if (grid->start_index != NO_INDEX) {
+        grid->start_index = get_index(grid, grid->start_index / grid->num_cols,
+            grid->start_index % grid->num_cols);
+    }
+    if (grid->end_index != NO_INDEX) {
+        grid->end_index = get_index(grid, grid->end_index / grid->num_cols,
+            grid->end_index % grid->num_cols);
+    }
+
+    // Nothing is read from the file any more.
+    munmap(grid->file, grid->file_size);
+    grid->file = NULL;
+#else
+    grid->obstacles = obstacles;
+    grid->costs = costs;
+#endif
+    return 0;
+}
+
+int set_num_cells(Grid* grid) {
+    /* Sets the number of cell indices of a grid of num_rows x num_cols cells (and its number of
+    tiles across). Returns 0, or -1 if there would be too many to index. */
+
+    uint64_t num_cells = (uint64_t) grid->num_rows * grid->num_cols;
+    grid->num_tile_cols = (grid->num_cols + TILE_SIZE - 1) / TILE_SIZE;
+#if LAYOUT == LAYOUT_TILED
+    uint64_t num_tile_rows = (grid->num_rows + TILE_SIZE - 1) / TILE_SIZE;
+    num_cells = num_tile_rows * grid->num_tile_cols * TILE_SIZE * TILE_SIZE;
+#endif
+    if (num_cells >= NO_INDEX) {
+        return -1;
+    }
+    grid->num_cells = num_cells;
+    return 0;
+}
+
+void pad_tiles(Grid* grid) {
+    // Makes the cells of partial tiles that lie outside of the map obstacles.
+#if LAYOUT == LAYOUT_TILED
+    int num_rows = (grid->num_rows + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+    int num_cols = grid->num_tile_cols * TILE_SIZE;
+    for (int row = 0; row < num_rows; row++) {
+        int first_col = (row < grid->num_rows) ? grid->num_cols : 0;
+        for (int col = first_col; col < num_cols; col++) {
+            set_cell(grid, get_index(grid, row, col), OBSTACLE);
+        }
+    }
+#else
+    (void) grid;
+#endif
+}
+
+void copy_cells(Grid* grid, uint64_t* from_obstacles, uint8_t* from_costs, uint64_t* to_obstacles,
+    uint8_t* to_costs, int to_tiles) {
+    /* Copies the obstacle bits and costs (if from_costs isn't NULL) of every cell from row by row
+    order into the grid's tiles, or the other way round, into cleared arrays. The 8 cells of a
+    tile's row are consecutive in both, so they are copied 8 at a time. */
+
+    for (int row = 0; row < grid->num_rows; row++) {
+        for (int col = 0; col < grid->num_cols; col += TILE_SIZE) {
+            int num_bits = (grid->num_cols - col < TILE_SIZE) ? grid->num_cols - col : TILE_SIZE;
+            uint32_t from = (uint32_t) row * grid->num_cols + col;
+            uint32_t to = get_index(grid, row, col);
+            if (to_tiles == 0) {
+                uint32_t tiled = to;
+                to = from;
+                from = tiled;
+            }
+
+            // Up to 8 bits from anywhere in from_obstacles, which may span two words.
+            uint64_t bits = from_obstacles[from / 64] >> (from % 64);
+            if (from % 64 > 64 - TILE_SIZE) {
+                bits |= from_obstacles[from / 64 + 1] << (64 - from % 64);
+            }
+            bits &= (1ULL << num_bits) - 1;
+
+            to_obstacles[to / 64] |= bits << (to % 64);
+            if ((int) (to % 64) > 64 - num_bits) {
+                to_obstacles[to / 64 + 1] |= bits >> (64 - to % 64);
+            }
+            if (from_costs != NULL) {
+                memcpy(&to_costs[to], &from_costs[from], num_bits);
+            }
+        }
+    }
+}
+
+int parse_number(char** text, char* end) {
+    // Reads a positive decimal number and moves text past it. Returns -1 if there is none.
+    int64_t number = 0;
+    char* p = *text;
+    while (p < end && *p >= '0' && *p <= '9' && number <= INT32_MAX) {
+        number = number * 10 + (*p++ - '0');
+    }
+    if (p == *text || number > INT32_MAX) {
+        return -1;
+    }
+    *text = p;
+    return (int) number;
+}
+
+int read_row(Grid* grid, char* line, int row) {
+    /* Packs one row of a text map into the obstacle bitmap. Rows are read 8 characters at a time,
+    and only groups of 8 holding something other than '_' and 'Z' are looked at one by one. */
+
+    int col = 0;
+
+    // The 8 cells of each group are consecutive in either layout.
+    for (; col + 8 <= grid->num_cols; col += 8) {
+        uint32_t index = get_index(grid, row, col);
+        uint64_t word;
+        memcpy(&word, line + col, sizeof word);
+        uint64_t obstacles = match_bytes(word, OBSTACLE);
+        if ((obstacles | match_bytes(word, EMPTY)) != 0x8080808080808080ULL) {
+            if (read_cells(grid, line, row, col, col + 8) == -1) {
+                return -1;
+            }
+            continue;
+        }
+
+        // Gather the top bit of each byte into the low 8 bits, in order, and put them at index.
+        uint64_t bits = ((obstacles >> 7) * 0x0102040810204080ULL) >> 56;
+        grid->obstacles[index / 64] |= bits << (index % 64);
+        if (index % 64 > 56) {
+            grid->obstacles[index / 64 + 1] |= bits >> (64 - index % 64);
+        }
+    }
+
+    return read_cells(grid, line, row, col, grid->num_cols);
+}
+
+int read_cells(Grid* grid, char* line, int row, int col, int end_col) {
+    /* Reads the cells of a row from col up to end_col one by one: the end of a row, or a group of
+    8 with a start, end, terrain or unknown character in it. */
+
+    for (; col < end_col; col++) {
+        uint32_t index = get_index(grid, row, col);
+        char cell_type = line[col];
+        if (cell_type == OBSTACLE) {
+            grid->obstacles[index / 64] |= 1ULL << (index % 64);
+        } else if (cell_type > '1' && cell_type <= '0' + MAX_TERRAIN_COST) {
+            set_cost(grid, index, cell_type - '0');
+        } else if (cell_type == START) {
+            grid->start_index = index;
+        } else if (cell_type == END) {
+            grid->end_index = index;
+            add_goal(grid, row, col);
+        } else if (cell_type == NEW_LINE || cell_type == '\r') {
+            printf("Row %d of the map is shorter than the header's %d columns.\n", row,
+                grid->num_cols);
+            return -1;
+        } else if (cell_type != EMPTY && cell_type != '1') {
+            printf("Unknown character '%c' at row %d, column %d of the map.\n", cell_type, row,
+                col);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+uint64_t match_bytes(uint64_t word, char c) {
+    /* Returns a mask with the top bit of every byte of word that equals c set, and every other bit
+    clear. */
+    uint64_t x = word ^ (0x0101010101010101ULL * (uint8_t) c);
+    uint64_t nonzero = (((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | x);
+    return ~nonzero & 0x8080808080808080ULL;
+}
+
+void set_cost(Grid* grid, uint32_t index, int cost) {
+    // Sets the terrain cost of a cell, giving the grid its costs (all 1) the first time.
+    if (grid->costs == NULL) {
+        grid->costs = malloc(grid->num_cells * sizeof *(grid->costs));
+        memset(grid->costs, 1, grid->num_cells * sizeof *(grid->costs));
+    }
+    grid->costs[index] = cost;
+}
+
+void add_goal(Grid* grid, int row, int col) {
+    // Adds an end to the grid's list of them.
+
+    Goals* goals = &grid->goals;
+    if (goals->num_goals == goals->curr_size) {
+        goals->curr_size = goals->curr_size ? goals->curr_size * 2 : 1;
+        goals->points = realloc(goals->points, goals->curr_size * sizeof *(goals->points));
+    }
+    goals->points[goals->num_goals].row = row;
+    goals->points[goals->num_goals].col = col;
+    goals->num_goals++;
+}
+
+void find_min_cost(Grid* grid) {
+    /* Sets the grid's min_cost to the lowest cost of its open cells (1 if it has none), stopping
+    at the first cell of cost 1, which almost every map has near its top. */
+
+    int min_cost = MAX_TERRAIN_COST + 1;
+    for (uint32_t i = 0; i < grid->num_cells && min_cost > 1; i++) {
+        if (!is_obstacle(grid, i) && grid->costs[i] < min_cost) {
+            min_cost = grid->costs[i];
+        }
+    }
+    grid->min_cost = (min_cost > MAX_TERRAIN_COST) ? 1 : min_cost;
+}
+
+int save_binary_map(Grid* grid, char* file_name) {
+    /* Saves a grid as a binary map, with its cells row by row whatever the layout. Returns 0, or
+    -1 if the file can't be written. */
+
+    uint64_t* obstacles = grid->obstacles;
+    uint8_t* costs = grid->costs;
+    size_t num_cells = (size_t) grid->num_rows * grid->num_cols;
+    size_t num_words = (num_cells + 63) / 64;
+    uint32_t start_index = grid->start_index, end_index = grid->end_index;
+#if LAYOUT == LAYOUT_TILED
+    obstacles = calloc(num_words, sizeof *(obstacles));
+    costs = (grid->costs != NULL) ? malloc(num_cells) : NULL;
+    copy_cells(grid, grid->obstacles, grid->costs, obstacles, costs, 0);
+    if (start_index != NO_INDEX) {
+        start_index = (uint32_t) get_row(grid, start_index) * grid->num_cols +
+            get_col(grid, start_index);
+    }
+    if (end_index != NO_INDEX) {
+        end_index = (uint32_t) get_row(grid, end_index) * grid->num_cols +
+            get_col(grid, end_index);
+    }
+#endif
+
+    MapHeader header;
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, MAP_MAGIC, sizeof header.magic);
+    header.num_rows = grid->num_rows;
+    header.num_cols = grid->num_cols;
+    header.start_index = start_index;
+    header.end_index = end_index;
+    header.min_cost = (grid->costs != NULL) ? grid->min_cost : 0;
+    header.num_goals = (grid->goals.num_goals > 1) ? grid->goals.num_goals : 0;
+
+    FILE* fp = fopen(file_name, "wb");
+    size_t num_costs = (costs != NULL) ? num_cells : 0;
+    int saved = (fp != NULL &&
+        fwrite(&header, sizeof header, 1, fp) == 1 &&
+        fwrite(obstacles, sizeof *(obstacles), num_words, fp) == num_words &&
+        (num_costs == 0 || fwrite(costs, sizeof(uint8_t), num_costs, fp) == num_costs));
+    for (uint32_t i = 0; saved && i < header.num_goals; i++) {
+        GoalPoint* point = &grid->goals.points[i];
+        uint32_t goal = (uint32_t) point->row * grid->num_cols + point->col;
+        saved = (fwrite(&goal, sizeof goal, 1, fp) == 1);
+    }
+    if (fp != NULL && fclose(fp) != 0) {
+        saved = 0;
+    }
+
+    if (obstacles != grid->obstacles) {
+        free(obstacles);
+        free(costs);
+    }
+    return saved ? 0 : -1;
+}
+
+size_t get_bitmap_words(Grid* grid) {
+    // Returns the number of 64-bit words in a bitmap of every cell of the grid.
+    return ((size_t) grid->num_cells + 63) / 64;
+}
+
+int is_obstacle(Grid* grid, uint32_t index) {
+    return (grid->obstacles[index / 64] >> (index % 64)) & 1;
+}
+
+void set_cell(Grid* grid, uint32_t index, char type) {
+    // Turns a cell into an obstacle (OBSTACLE) or open space (anything else).
+    if (type == OBSTACLE) {
+        grid->obstacles[index / 64] |= 1ULL << (index % 64);
+    } else {
+        grid->obstacles[index / 64] &= ~(1ULL << (index % 64));
+    }
+}
+
+uint32_t get_index(Grid* grid, int row, int col) {
+    // Returns the index of the cell at a row and column.
+#if LAYOUT == LAYOUT_TILED
+    uint32_t tile = (uint32_t) (row / TILE_SIZE) * grid->num_tile_cols + col / TILE_SIZE;
+    return tile * TILE_SIZE * TILE_SIZE + (row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE;
+#else
+    return (uint32_t) row * grid->num_cols + col;
+#endif
+}
+
+int get_row(Grid* grid, uint32_t index) {
+#if LAYOUT == LAYOUT_TILED
+    uint32_t tile = index / (TILE_SIZE * TILE_SIZE);
+    return tile / grid->num_tile_cols * TILE_SIZE + index / TILE_SIZE % TILE_SIZE;
+#else
+    return index / grid->num_cols;
+#endif
+}
+
+int get_col(Grid* grid, uint32_t index) {
+#if LAYOUT == LAYOUT_TILED
+    uint32_t tile = index / (TILE_SIZE * TILE_SIZE);
+    return tile % grid->num_tile_cols * TILE_SIZE + index % TILE_SIZE;
+#else
+    return index % grid->num_cols;
+#endif
+}
+
+static ALWAYS_INLINE uint32_t step_index(Grid* grid, uint32_t index, int dy, int dx) {
+    /* Returns the index of the cell dy rows and dx columns (each -1, 0 or 1) away from a cell,
+    which must be on the map. With the steps known when inlined, this is one addition in row by
+    row order, and one or two in tiles, depending on whether the step leaves the tile. */
+
+#if LAYOUT == LAYOUT_TILED
+    uint32_t tile_cells = TILE_SIZE * TILE_SIZE;
+    uint32_t tile_row_cells = grid->num_tile_cols * tile_cells;
+    uint32_t row = index / TILE_SIZE % TILE_SIZE, col = index % TILE_SIZE;
+    if (dx == -1) {
+        index += (col == 0) ? TILE_SIZE - 1 - tile_cells : (uint32_t) -1;
+    } else if (dx == 1) {
+        index += (col == TILE_SIZE - 1) ? tile_cells - (TILE_SIZE - 1) : 1;
+    }
+    if (dy == -1) {
+        index += (row == 0) ? tile_cells - TILE_SIZE - tile_row_cells : (uint32_t) -TILE_SIZE;
+    } else if (dy == 1) {
+        index += (row == TILE_SIZE - 1) ? tile_row_cells - (tile_cells - TILE_SIZE) : TILE_SIZE;
+    }
+    return index;
+#else
+    return index + dy * grid->num_cols + dx;
+#endif
+}
+
+char get_cell_type(Grid* grid, uint32_t index) {
+    // Returns the character a cell is printed as, including the path drawn over the map.
+    if (index == grid->start_index) {
+        return START;
+    } else if (index == grid->end_index || (grid->goals.bitmap != NULL &&
+        (grid->goals.bitmap[index / 64] >> (index % 64)) & 1)) {
+        return END;
+    } else if (is_obstacle(grid, index)) {
+        return OBSTACLE;
+    } else if (grid->path != NULL && (grid->path[index / 64] >> (index % 64)) & 1) {
+        return PATH_CHAR;
+    } else if (grid->costs != NULL && grid->costs[index] > 1) {
+        return '0' + grid->costs[index];
+    }
+    return EMPTY;
+}
+
+void mark_path(Grid* grid, uint32_t index) {
+    // Marks a cell to be printed as part of the path.
+    if (grid->path == NULL) {
+        grid->path = calloc(get_bitmap_words(grid), sizeof *(grid->path));
+    }
+    grid->path[index / 64] |= 1ULL << (index % 64);
+}
+
+void free_map(Grid* grid) {
+    if (grid->file != NULL) {
+        munmap(grid->file, grid->file_size);
+    } else {
+        free(grid->obstacles);
+        free(grid->costs);
+    }
+    free(grid->path);
+    free(grid->goals.points);
+    free(grid->goals.bitmap);
+}
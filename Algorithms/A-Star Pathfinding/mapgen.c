@@ -0,0 +1,343 @@
+// Generates large maps in the text format read by main.c, for benchmarking searches on maps far
+// bigger than the hand-drawn ones in maps/. The same type, size and seed always give the same
+// map, on any machine.
+//
+// Usage: mapgen TYPE ROWS COLS SEED [DENSITY] > map
+//
+// Types:
+//  - random: every cell is an obstacle with probability DENSITY (0.25 by default).
+//  - maze:   a perfect maze (exactly one path between any two cells) carved by a recursive
+//            backtracker, with corridors and walls one cell wide.
+//  - rooms:  rectangular rooms, one per ROOM_BLOCK x ROOM_BLOCK block of the map, joined by
+//            corridors along a random spanning tree of the blocks plus a few extra corridors
+//            that make loops.
+//  - open:   open ground with small rectangular obstacles scattered over about DENSITY (0.05 by
+//            default) of it.
+//  - terrain: an open map whose ground is about half covered with patches of costlier terrain
+//            ('2' to '9', see map.h).
+//
+// The start is put in the top left and the end in the bottom right. Maze and rooms maps always
+// have a path between them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define START 'S'
+#define END 'E'
+#define OBSTACLE 'Z'
+#define EMPTY '_'
+#define NEW_LINE '\n'
+
+#define ROOM_BLOCK 24      // The side of the block of the map each room is put in.
+#define LOOP_CHANCE 10     // The percentage of neighboring rooms joined by an extra corridor.
+#define MAX_OBSTACLE 8     // The largest side of an obstacle on open maps.
+#define MAX_PATCH 32       // The largest side of a patch of terrain on terrain maps.
+#define MAX_TERRAIN_COST 9
+
+// The links of a cell in a spanning tree (see make_spanning_tree).
+#define LINK_RIGHT 1
+#define LINK_DOWN 2
+#define FROM_SHIFT 2       // Where the direction a cell was first reached from is kept.
+#define FROM_ROOT 5
+
+typedef struct {
+    int num_rows;
+    int num_cols;
+    char* cells;           // Indexed by row * num_cols + col.
+} Map;
+
+// Function declarations --------------------------------------------------------------------------
+
+uint64_t next_random(uint64_t* state);
+int random_below(uint64_t* state, int n);
+void make_random(Map* map, uint64_t* rng, double density);
+void make_maze(Map* map, uint64_t* rng);
+void make_rooms(Map* map, uint64_t* rng);
+void make_open(Map* map, uint64_t* rng, double density);
+void make_terrain(Map* map, uint64_t* rng, double density);
+void make_spanning_tree(uint8_t* links, int num_rows, int num_cols, uint64_t* rng);
+void fill_rect(Map* map, int row1, int col1, int row2, int col2, char type);
+void save_map(Map* map);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 5) {
+        printf("Usage: mapgen random|maze|rooms|open|terrain ROWS COLS SEED [DENSITY]\n");
+        return 1;
+    }
+
+    Map map;
+    map.num_rows = atoi(argv[2]);
+    map.num_cols = atoi(argv[3]);
+    uint64_t rng = strtoull(argv[4], NULL, 10);
+    double density = (argc > 5) ? atof(argv[5]) : -1;
+
+    if (map.num_rows < 3 || map.num_cols < 3 ||
+        (uint64_t) map.num_rows * map.num_cols >= UINT32_MAX) {
+        printf("Maps must be at least 3x3, with fewer than 2^32 cells.\n");
+        return 1;
+    }
+
+    map.cells = malloc((size_t) map.num_rows * map.num_cols);
+    if (map.cells == NULL) {
+        printf("Not enough memory for a %dx%d map.\n", map.num_rows, map.num_cols);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "random") == 0) {
+        make_random(&map, &rng, (density < 0) ? 0.25 : density);
+    } else if (strcmp(argv[1], "maze") == 0) {
+        make_maze(&map, &rng);
+    } else if (strcmp(argv[1], "rooms") == 0) {
+        if (map.num_rows < ROOM_BLOCK || map.num_cols < ROOM_BLOCK) {
+            printf("Rooms maps must be at least %dx%d.\n", ROOM_BLOCK, ROOM_BLOCK);
+            return 1;
+        }
+        make_rooms(&map, &rng);
+    } else if (strcmp(argv[1], "open") == 0) {
+        make_open(&map, &rng, (density < 0) ? 0.05 : density);
+    } else if (strcmp(argv[1], "terrain") == 0) {
+        make_terrain(&map, &rng, (density < 0) ? 0.05 : density);
+    } else {
+        printf("Unknown map type '%s' (expected random, maze, rooms, open or terrain).\n",
+            argv[1]);
+        return 1;
+    }
+
+    save_map(&map);
+    free(map.cells);
+    return 0;
+}
+
+uint64_t next_random(uint64_t* state) {
+    // SplitMix64: a fast generator whose output only depends on the seed.
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int random_below(uint64_t* state, int n) {
+    // Returns a random number from 0 to n - 1.
+    return (int) (((next_random(state) >> 32) * (uint64_t) n) >> 32);
+}
+
+void make_random(Map* map, uint64_t* rng, double density) {
+    uint64_t threshold = (uint64_t) (density * 4294967296.0);
+    size_t num_cells = (size_t) map->num_rows * map->num_cols;
+    for (size_t i = 0; i < num_cells; i++) {
+        map->cells[i] = ((next_random(rng) >> 32) < threshold) ? OBSTACLE : EMPTY;
+    }
+
+    map->cells[0] = START;
+    map->cells[num_cells - 1] = END;
+}
+
+void make_maze(Map* map, uint64_t* rng) {
+    /* Carves a maze into a map of walls. The maze's cells are the map cells with odd row and
+    column, and the walls between them are knocked down along a random spanning tree of them. */
+
+    int maze_rows = (map->num_rows - 1) / 2, maze_cols = (map->num_cols - 1) / 2;
+    uint8_t* links = calloc((size_t) maze_rows * maze_cols, sizeof *(links));
+    make_spanning_tree(links, maze_rows, maze_cols, rng);
+
+    memset(map->cells, OBSTACLE, (size_t) map->num_rows * map->num_cols);
+    for (int r = 0; r < maze_rows; r++) {
+        for (int c = 0; c < maze_cols; c++) {
+            int row = 2 * r + 1, col = 2 * c + 1;
+            uint8_t link = links[(size_t) r * maze_cols + c];
+            map->cells[(size_t) row * map->num_cols + col] = EMPTY;
+            if (link & LINK_RIGHT) {
+                map->cells[(size_t) row * map->num_cols + col + 1] = EMPTY;
+            }
+            if (link & LINK_DOWN) {
+                map->cells[(size_t) (row + 1) * map->num_cols + col] = EMPTY;
+            }
+        }
+    }
+
+    map->cells[(size_t) map->num_cols + 1] = START;
+    map->cells[(size_t) (2 * maze_rows - 1) * map->num_cols + 2 * maze_cols - 1] = END;
+    free(links);
+}
+
+void make_rooms(Map* map, uint64_t* rng) {
+    /* Puts a room of random size and position in each block of the map, keeping a wall between
+    it and the next block's room, then joins the centers of the rooms of linked blocks with
+    L-shaped corridors one or two cells wide. */
+
+    int block_rows = map->num_rows / ROOM_BLOCK, block_cols = map->num_cols / ROOM_BLOCK;
+    size_t num_blocks = (size_t) block_rows * block_cols;
+    uint8_t* links = calloc(num_blocks, sizeof *(links));
+    int* centers = malloc(num_blocks * 2 * sizeof *(centers));
+    make_spanning_tree(links, block_rows, block_cols, rng);
+
+    memset(map->cells, OBSTACLE, (size_t) map->num_rows * map->num_cols);
+    for (size_t i = 0; i < num_blocks; i++) {
+        int height = ROOM_BLOCK / 4 + random_below(rng, ROOM_BLOCK * 3 / 4 - 1);
+        int width = ROOM_BLOCK / 4 + random_below(rng, ROOM_BLOCK * 3 / 4 - 1);
+        int row = (int) (i / block_cols) * ROOM_BLOCK + 1 +
+            random_below(rng, ROOM_BLOCK - height - 1);
+        int col = (int) (i % block_cols) * ROOM_BLOCK + 1 +
+            random_below(rng, ROOM_BLOCK - width - 1);
+        fill_rect(map, row, col, row + height - 1, col + width - 1, EMPTY);
+        centers[2 * i] = row + height / 2;
+        centers[2 * i + 1] = col + width / 2;
+
+        // Extra links to make loops.
+        if (i % block_cols + 1 < (size_t) block_cols && random_below(rng, 100) < LOOP_CHANCE) {
+            links[i] |= LINK_RIGHT;
+        }
+        if (i / block_cols + 1 < (size_t) block_rows && random_below(rng, 100) < LOOP_CHANCE) {
+            links[i] |= LINK_DOWN;
+        }
+    }
+
+    for (size_t i = 0; i < num_blocks; i++) {
+        for (int link = LINK_RIGHT; link <= LINK_DOWN; link++) {
+            if (!(links[i] & link)) {
+                continue;
+            }
+            size_t next = (link == LINK_RIGHT) ? i + 1 : i + block_cols;
+            int width = random_below(rng, 2);
+            int row1 = centers[2 * i], col1 = centers[2 * i + 1];
+            int row2 = centers[2 * next], col2 = centers[2 * next + 1];
+            fill_rect(map, row1, col1, row1 + width, col2, EMPTY);
+            fill_rect(map, row1, col2, row2, col2 + width, EMPTY);
+        }
+    }
+
+    map->cells[(size_t) centers[0] * map->num_cols + centers[1]] = START;
+    map->cells[(size_t) centers[2 * num_blocks - 2] * map->num_cols +
+        centers[2 * num_blocks - 1]] = END;
+    free(centers);
+    free(links);
+}
+
+void make_open(Map* map, uint64_t* rng, double density) {
+    size_t num_cells = (size_t) map->num_rows * map->num_cols;
+    memset(map->cells, EMPTY, num_cells);
+
+    // Obstacles are (MAX_OBSTACLE + 1)^2 / 4 cells on average, and may overlap.
+    size_t num_obstacles = (size_t) (density * num_cells * 4 /
+        ((MAX_OBSTACLE + 1) * (MAX_OBSTACLE + 1)));
+    for (size_t i = 0; i < num_obstacles; i++) {
+        int row = random_below(rng, map->num_rows), col = random_below(rng, map->num_cols);
+        fill_rect(map, row, col, row + random_below(rng, MAX_OBSTACLE),
+            col + random_below(rng, MAX_OBSTACLE), OBSTACLE);
+    }
+
+    map->cells[0] = START;
+    map->cells[num_cells - 1] = END;
+}
+
+void make_terrain(Map* map, uint64_t* rng, double density) {
+    /* Makes an open map, then lays patches of random terrain over its open ground. Patches are
+    (MAX_PATCH + 1)^2 / 4 cells on average and may overlap, the later one winning. */
+
+    make_open(map, rng, density);
+    size_t num_cells = (size_t) map->num_rows * map->num_cols;
+    size_t num_patches = num_cells * 2 / ((MAX_PATCH + 1) * (MAX_PATCH + 1));
+    for (size_t i = 0; i < num_patches; i++) {
+        int row1 = random_below(rng, map->num_rows), col1 = random_below(rng, map->num_cols);
+        int row2 = row1 + random_below(rng, MAX_PATCH), col2 = col1 + random_below(rng, MAX_PATCH);
+        row2 = (row2 >= map->num_rows) ? map->num_rows - 1 : row2;
+        col2 = (col2 >= map->num_cols) ? map->num_cols - 1 : col2;
+        char type = '2' + random_below(rng, MAX_TERRAIN_COST - 1);
+        for (int row = row1; row <= row2; row++) {
+            for (int col = col1; col <= col2; col++) {
+                char* cell = &map->cells[(size_t) row * map->num_cols + col];
+                if (*cell != OBSTACLE && *cell != START && *cell != END) {
+                    *cell = type;
+                }
+            }
+        }
+    }
+}
+
+void make_spanning_tree(uint8_t* links, int num_rows, int num_cols, uint64_t* rng) {
+    /* Links the cells of a num_rows x num_cols grid (held in links, which must start zeroed)
+    into a random spanning tree with a recursive backtracker: walk to a random unvisited
+    neighbor, linking it to the current cell, and step back once there are none. The direction
+    each cell was first reached from is kept in its links, so stepping back needs no stack. */
+
+    int steps[4][2] = { {0, 1}, {1, 0}, {0, -1}, {-1, 0} };
+    int row = 0, col = 0;
+    links[0] = FROM_ROOT << FROM_SHIFT;
+
+    while (1) {
+        size_t index = (size_t) row * num_cols + col;
+        int dirs[4], num_dirs = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            int r = row + steps[dir][0], c = col + steps[dir][1];
+            if (r >= 0 && r < num_rows && c >= 0 && c < num_cols &&
+                !(links[(size_t) r * num_cols + c] >> FROM_SHIFT)) {
+                dirs[num_dirs++] = dir;
+            }
+        }
+
+        if (num_dirs == 0) {
+            int from = (links[index] >> FROM_SHIFT) - 1;
+            if (from + 1 == FROM_ROOT) {
+                break;
+            }
+            row -= steps[from][0];
+            col -= steps[from][1];
+            continue;
+        }
+
+        int dir = dirs[random_below(rng, num_dirs)];
+        row += steps[dir][0];
+        col += steps[dir][1];
+        size_t next = (size_t) row * num_cols + col;
+        links[next] |= (dir + 1) << FROM_SHIFT;
+
+        // Links are kept on the cell above or to the left.
+        if (dir == 0) {
+            links[index] |= LINK_RIGHT;
+        } else if (dir == 1) {
+            links[index] |= LINK_DOWN;
+        } else if (dir == 2) {
+            links[next] |= LINK_RIGHT;
+        } else {
+            links[next] |= LINK_DOWN;
+        }
+    }
+}
+
+void fill_rect(Map* map, int row1, int col1, int row2, int col2, char type) {
+    // Sets every cell between two corners (in any order, clipped to the map) to type.
+    if (row1 > row2) {
+        int temp = row1;
+        row1 = row2;
+        row2 = temp;
+    }
+    if (col1 > col2) {
+        int temp = col1;
+        col1 = col2;
+        col2 = temp;
+    }
+    row1 = (row1 < 0) ? 0 : row1;
+    col1 = (col1 < 0) ? 0 : col1;
+    row2 = (row2 >= map->num_rows) ? map->num_rows - 1 : row2;
+    col2 = (col2 >= map->num_cols) ? map->num_cols - 1 : col2;
+
+    for (int row = row1; row <= row2; row++) {
+        if (col1 <= col2) {
+            memset(&map->cells[(size_t) row * map->num_cols + col1], type, col2 - col1 + 1);
+        }
+    }
+}
+
+void save_map(Map* map) {
+    // Writes the map to standard output: the "ROWSxCOLS" header, a blank line and the rows.
+    printf("%dx%d\n\n", map->num_rows, map->num_cols);
+    for (int row = 0; row < map->num_rows; row++) {
+        fwrite(&map->cells[(size_t) row * map->num_cols], 1, map->num_cols, stdout);
+        putchar(NEW_LINE);
+    }
+}
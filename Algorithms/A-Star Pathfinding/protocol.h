@@ -0,0 +1,93 @@
+// The protocol of the path-finding server (see server.h), shared with its client (client.c).
+//
+// Clients connect to the server's Unix domain socket and send requests, each a frame that starts
+// with its length: a ServerRequest, whose length field holds the number of bytes after it. A
+// client can send any number of requests without waiting for their answers (pipelining), and
+// each is answered with a ServerResponse frame carrying the same id, in whatever order they are
+// done, since several worker threads answer the requests of one connection at once. Everything is
+// in the byte order of the machine, as both ends of a Unix socket are on the same one.
+//
+// A response is followed by its payload, whose size is the response's length minus that of the
+// rest of the response:
+//  - For a SERVER_QUERY with SERVER_WANT_PATH, the cells of the path from start to end, each an
+//    int32_t row and column.
+//  - For SERVER_STATS, the server's counts and latency percentiles as one line of JSON text.
+//
+// A frame of the wrong length or an unknown type means the client is not speaking the protocol,
+// so the server closes the connection instead of answering.
+
+#include <errno.h>
+
+#define SERVER_QUERY 1 // Find a path.
+#define SERVER_STATS 2 // Report the server's counts and latencies.
+
+// Request flags.
+#define SERVER_WANT_PATH 1   // Send a query's path back, not only its cost.
+#define SERVER_RESET_STATS 1 // Clear the counts and latencies after reporting them.
+
+// Response statuses.
+#define SERVER_OK 0
+#define SERVER_NO_PATH 1     // The ends aren't connected, or one of them is an obstacle.
+#define SERVER_BAD_REQUEST 2 // No such map, or a cell outside of it.
+
+typedef struct {
+    uint32_t length;   // The number of bytes after this field.
+    uint32_t type;     // SERVER_QUERY or SERVER_STATS.
+    uint32_t id;       // Copied into the response, to match it to its request.
+    uint32_t flags;
+    uint32_t map;      // The index of the map, in the order the server was given them.
+    int32_t start_row;
+    int32_t start_col;
+    int32_t end_row;   // -1 (with end_col -1) for the nearest of the map's ends (see goals.h).
+    int32_t end_col;
+} ServerRequest;
+
+typedef struct {
+    uint32_t length;   // The number of bytes after this field, counting the payload.
+    uint32_t type;
+    uint32_t id;
+    int32_t status;
+    int32_t path_cost; // -1 unless the status is SERVER_OK.
+    uint32_t num_expanded;
+} ServerResponse;
+
+// Function declarations --------------------------------------------------------------------------
+
+int read_full(int fd, void* buffer, size_t size);
+int write_full(int fd, void* buffer, size_t size);
+
+// Function declarations end ----------------------------------------------------------------------
+
+int read_full(int fd, void* buffer, size_t size) {
+    /* Reads exactly size bytes from a socket. Returns 0, or -1 if it is closed or fails first. */
+
+    char* p = buffer;
+    while (size > 0) {
+        ssize_t num_read = read(fd, p, size);
+        if (num_read == -1 && errno == EINTR) {
+            continue;
+        } else if (num_read <= 0) {
+            return -1;
+        }
+        p += num_read;
+        size -= num_read;
+    }
+    return 0;
+}
+
+int write_full(int fd, void* buffer, size_t size) {
+    // Like read_full, writing.
+
+    char* p = buffer;
+    while (size > 0) {
+        ssize_t num_written = write(fd, p, size);
+        if (num_written == -1 && errno == EINTR) {
+            continue;
+        } else if (num_written <= 0) {
+            return -1;
+        }
+        p += num_written;
+        size -= num_written;
+    }
+    return 0;
+}
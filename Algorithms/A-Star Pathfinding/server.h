@@ -0,0 +1,432 @@
+// Server mode: a long-running process that loads its maps once and answers path queries sent over
+// a Unix domain socket (see protocol.h), so a query pays for neither starting the program nor
+// loading the map.
+//
+// Every map given on the command line is loaded, labelled and indexed up front, and then only
+// read. Each connection gets a thread that reads its requests as they arrive, without waiting for
+// the answers of earlier ones, and puts them on a shared queue. A pool of worker threads takes
+// requests off the queue and answers them, each with a Search of its own per map (allocated the
+// first time the worker gets a query for that map, and reused for every later one), and writes
+// the response back on the request's connection. A connection is closed once its client has
+// hung up and the last of its requests is answered.
+//
+// The queue holds at most SERVER_QUEUE_SIZE requests. When it's full, connection threads wait
+// before reading more, so a client sending faster than the workers can answer is slowed down to
+// their pace instead of the server's memory growing.
+//
+// A client that sends requests but doesn't read its answers fills its socket's buffer, and the
+// workers answering it would wait to write forever, until none were left for anyone else. Writes
+// to a connection give up after SERVER_SEND_TIMEOUT seconds instead, and the connection is dropped.
+//
+// The server keeps a latency histogram (see histogram.h) of the time from each request being read
+// to its response being ready to write, which counts the time it spent waiting on the queue, and
+// sends its percentiles in answer to SERVER_STATS requests.
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define SERVER_QUEUE_SIZE 1024
+#define SERVER_BACKLOG 64
+#define INIT_PATH_SIZE 256
+#define SERVER_SEND_TIMEOUT 5 // Seconds a response can wait to be written before giving up.
+
+// A client's connection, shared by its reader thread and the workers answering its requests.
+typedef struct {
+    struct server* server;
+    int fd;
+    pthread_mutex_t write_lock; // Held while writing a response, so responses don't interleave.
+    atomic_int num_refs;        // The reader, plus every request of it not yet answered.
+} Connection;
+
+typedef struct {
+    Connection* connection;
+    ServerRequest request;
+    double read_time;
+} ServerJob;
+
+typedef struct server {
+    Grid* grids;
+    int num_maps;
+    int backend;
+    int num_threads;
+    ServerJob* jobs;            // A ring of SERVER_QUEUE_SIZE requests waiting for a worker.
+    int first_job;
+    int num_jobs;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    Histogram latencies;
+    atomic_uint_least64_t num_queries;
+    atomic_uint_least64_t num_no_path;
+    atomic_uint_least64_t num_bad;
+    atomic_int num_connections;
+} Server;
+
+// A worker thread's searches, one per map.
+typedef struct {
+    Server* server;
+    Search* searches;
+    int32_t* path;              // Cells of the path being sent back, as row and column pairs.
+    int path_size;
+} ServerWorker;
+
+// Function declarations --------------------------------------------------------------------------
+
+int run_server(char** map_names, int num_maps, char* socket_path, int num_threads, int backend,
+    int moves);
+int open_server_socket(char* socket_path);
+void stop_server(int signal_number);
+void block_stop_signals();
+void* read_connection(void* arg);
+void release_connection(Connection* connection);
+void* server_worker(void* arg);
+void answer_server_query(ServerWorker* worker, ServerRequest* request, ServerResponse* response);
+int get_server_path(ServerWorker* worker, Search* search);
+int write_server_stats(Server* server, char* text, int size, int reset);
+void send_response(Server* server, ServerJob* job, ServerResponse* response, void* payload,
+    uint32_t payload_size);
+
+// Function declarations end ----------------------------------------------------------------------
+
+volatile sig_atomic_t server_stopped = 0;
+
+int run_server(char** map_names, int num_maps, char* socket_path, int num_threads, int backend,
+    int moves) {
+    /* Loads every map, then answers requests on socket_path with num_threads workers (one per
+    core if num_threads is 0) until interrupted. */
+
+    Server server;
+    memset(&server, 0, sizeof server);
+    server.grids = malloc(num_maps * sizeof *(server.grids));
+    server.num_maps = num_maps;
+    server.backend = backend;
+    for (int i = 0; i < num_maps; i++) {
+        if (load_map(map_names[i], &server.grids[i]) == -1) {
+            printf("Could not load map '%s'. Exiting...\n", map_names[i]);
+            return 0;
+        }
+        label_components(&server.grids[i]);
+        index_goals(&server.grids[i]);
+        server.grids[i].moves = moves;
+    }
+
+    if (num_threads <= 0) {
+        num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    server.num_threads = num_threads;
+    server.jobs = malloc(SERVER_QUEUE_SIZE * sizeof *(server.jobs));
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.not_empty, NULL);
+    pthread_cond_init(&server.not_full, NULL);
+    clear_histogram(&server.latencies);
+
+    int server_fd = open_server_socket(socket_path);
+    if (server_fd == -1) {
+        printf("Could not listen on '%s'. Exiting...\n", socket_path);
+        return 0;
+    }
+
+    // Stop on an interrupt, without restarting accept, so the socket file can be removed. A
+    // client hanging up mid-response only fails that write.
+    struct sigaction action;
+    memset(&action, 0, sizeof action);
+    action.sa_handler = stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_t thread;
+    for (int i = 0; i < num_threads; i++) {
+        pthread_create(&thread, NULL, server_worker, &server);
+        pthread_detach(thread);
+    }
+
+    printf("Serving %d maps on '%s' with %d threads.\n", num_maps, socket_path, num_threads);
+    fflush(stdout);
+
+    while (!server_stopped) {
+        int fd = accept(server_fd, NULL, NULL);
+        if (fd == -1) {
+            continue;
+        }
+
+        struct timeval send_timeout = {.tv_sec = SERVER_SEND_TIMEOUT};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof send_timeout);
+
+        Connection* connection = malloc(sizeof *(connection));
+        connection->server = &server;
+        connection->fd = fd;
+        pthread_mutex_init(&connection->write_lock, NULL);
+        atomic_init(&connection->num_refs, 1);
+        atomic_fetch_add(&server.num_connections, 1);
+        if (pthread_create(&thread, NULL, read_connection, connection) != 0) {
+            atomic_fetch_sub(&server.num_connections, 1);
+            release_connection(connection);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    close(server_fd);
+    unlink(socket_path);
+    printf("Stopped after %" PRIu64 " queries.\n", (uint64_t) atomic_load(&server.num_queries));
+    return 0;
+}
+
+int open_server_socket(char* socket_path) {
+    /* Creates a Unix domain socket at socket_path, replacing a socket left there by an earlier
+    server (but no other kind of file), and listens on it. Returns its file descriptor, or -1 if
+    it can't. */
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof address.sun_path) {
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    struct stat file_stat;
+    if (stat(socket_path, &file_stat) == 0 && S_ISSOCK(file_stat.st_mode)) {
+        unlink(socket_path);
+    }
+    if (bind(fd, (struct sockaddr*) &address, sizeof address) == -1 ||
+        listen(fd, SERVER_BACKLOG) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void stop_server(int signal_number) {
+    (void) signal_number;
+    server_stopped = 1;
+}
+
+void block_stop_signals() {
+    // Leaves the signals that stop the server to the thread waiting in accept.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+}
+
+void* read_connection(void* arg) {
+    /* Connection thread body. Reads requests until the client hangs up or breaks the protocol,
+    queueing each for the workers. */
+
+    Connection* connection = arg;
+    Server* server = connection->server;
+    block_stop_signals();
+
+    ServerJob job;
+    job.connection = connection;
+    while (read_full(connection->fd, &job.request, sizeof job.request.length) == 0) {
+        if (job.request.length != sizeof job.request - sizeof job.request.length ||
+            read_full(connection->fd, &job.request.type, job.request.length) == -1 ||
+            (job.request.type != SERVER_QUERY && job.request.type != SERVER_STATS)) {
+            // Stop both ways, so a client that broke the protocol sees the connection close at
+            // once, instead of after the answers of its earlier requests.
+            shutdown(connection->fd, SHUT_RDWR);
+            break;
+        }
+        job.read_time = get_time();
+        atomic_fetch_add(&connection->num_refs, 1);
+
+        pthread_mutex_lock(&server->lock);
+        while (server->num_jobs == SERVER_QUEUE_SIZE) {
+            pthread_cond_wait(&server->not_full, &server->lock);
+        }
+        server->jobs[(server->first_job + server->num_jobs) % SERVER_QUEUE_SIZE] = job;
+        server->num_jobs++;
+        pthread_cond_signal(&server->not_empty);
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    // On a hang-up, the connection stays open for the answers still to be sent, and is closed
+    // when the last of them drops its reference.
+    atomic_fetch_sub(&server->num_connections, 1);
+    release_connection(connection);
+    return NULL;
+}
+
+void release_connection(Connection* connection) {
+    // Drops a reference to a connection, closing it once nothing refers to it.
+    if (atomic_fetch_sub(&connection->num_refs, 1) == 1) {
+        close(connection->fd);
+        pthread_mutex_destroy(&connection->write_lock);
+        free(connection);
+    }
+}
+
+void* server_worker(void* arg) {
+    /* Worker thread body. Takes requests off the queue one at a time and answers them. */
+
+    ServerWorker worker;
+    worker.server = arg;
+    worker.searches = calloc(worker.server->num_maps, sizeof *(worker.searches));
+    worker.path_size = INIT_PATH_SIZE;
+    worker.path = malloc(worker.path_size * 2 * sizeof *(worker.path));
+    Server* server = worker.server;
+    block_stop_signals();
+
+    char text[512];
+    while (1) {
+        pthread_mutex_lock(&server->lock);
+        while (server->num_jobs == 0) {
+            pthread_cond_wait(&server->not_empty, &server->lock);
+        }
+        ServerJob job = server->jobs[server->first_job];
+        server->first_job = (server->first_job + 1) % SERVER_QUEUE_SIZE;
+        server->num_jobs--;
+        pthread_cond_signal(&server->not_full);
+        pthread_mutex_unlock(&server->lock);
+
+        ServerResponse response;
+        memset(&response, 0, sizeof response);
+        response.type = job.request.type;
+        response.id = job.request.id;
+        response.path_cost = -1;
+
+        if (job.request.type == SERVER_STATS) {
+            int size = write_server_stats(server, text, sizeof text,
+                job.request.flags & SERVER_RESET_STATS);
+            send_response(server, &job, &response, text, size);
+        } else {
+            answer_server_query(&worker, &job.request, &response);
+            int path_len = (response.status == SERVER_OK &&
+                (job.request.flags & SERVER_WANT_PATH)) ? get_server_path(&worker,
+                &worker.searches[job.request.map]) : 0;
+            send_response(server, &job, &response, worker.path,
+                path_len * 2 * sizeof *(worker.path));
+        }
+        release_connection(job.connection);
+    }
+
+    return NULL;
+}
+
+void answer_server_query(ServerWorker* worker, ServerRequest* request, ServerResponse* response) {
+    /* Finds the path of a query with the worker's search of its map, and saves its cost and
+    status into response. */
+
+    Server* server = worker->server;
+    if (request->map >= (uint32_t) server->num_maps) {
+        response->status = SERVER_BAD_REQUEST;
+        return;
+    }
+
+    Grid* grid = &server->grids[request->map];
+    int nearest = (request->end_row == -1 && request->end_col == -1);
+    if (request->start_row < 0 || request->start_row >= grid->num_rows ||
+        request->start_col < 0 || request->start_col >= grid->num_cols ||
+        (nearest && grid->goals.num_goals == 0) || (!nearest &&
+        (request->end_row < 0 || request->end_row >= grid->num_rows ||
+        request->end_col < 0 || request->end_col >= grid->num_cols))) {
+        response->status = SERVER_BAD_REQUEST;
+        return;
+    }
+
+    Search* search = &worker->searches[request->map];
+    if (search->nodes == NULL) {
+        init_search(search, grid, NULL, server->backend);
+    }
+
+    uint32_t start_index = get_index(grid, request->start_row, request->start_col);
+    if (nearest && grid->goals.num_goals > 1) {
+        search->goals = &grid->goals;
+        reset_search(search, start_index, NO_INDEX);
+    } else {
+        search->goals = NULL;
+        reset_search(search, start_index, nearest ? grid->end_index :
+            get_index(grid, request->end_row, request->end_col));
+    }
+
+    response->path_cost = find_path(search);
+    response->status = (response->path_cost == -1) ? SERVER_NO_PATH : SERVER_OK;
+    response->num_expanded = search->num_expanded;
+}
+
+int get_server_path(ServerWorker* worker, Search* search) {
+    /* Saves the cells of the path the search found into the worker's path, from start to end.
+    Returns the number of cells. */
+
+    Grid* grid = search->grid;
+    int path_len = 1;
+    for (uint32_t index = search->end_index; index != search->start_index;
+        index = search->nodes[index].prev_index) {
+        path_len++;
+    }
+    if (path_len > worker->path_size) {
+        worker->path_size = path_len;
+        worker->path = realloc(worker->path, worker->path_size * 2 * sizeof *(worker->path));
+    }
+
+    uint32_t index = search->end_index;
+    for (int i = path_len - 1; i >= 0; i--) {
+        worker->path[2 * i] = get_row(grid, index);
+        worker->path[2 * i + 1] = get_col(grid, index);
+        index = search->nodes[index].prev_index;
+    }
+    return path_len;
+}
+
+int write_server_stats(Server* server, char* text, int size, int reset) {
+    /* Writes the server's counts and latency percentiles (in microseconds) into text as one line
+    of JSON, clearing them afterwards if reset is set. Returns the length of the text. */
+
+    Histogram* latencies = &server->latencies;
+    uint64_t num_values = atomic_load(&latencies->num_values);
+    int len = snprintf(text, size, "{\"maps\": %d, \"threads\": %d, \"connections\": %d, "
+        "\"queries\": %" PRIu64 ", \"no_path\": %" PRIu64 ", \"bad_requests\": %" PRIu64 ", "
+        "\"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+        "\"p999_us\": %.1f, \"max_us\": %.1f}\n", server->num_maps, server->num_threads,
+        atomic_load(&server->num_connections), (uint64_t) atomic_load(&server->num_queries),
+        (uint64_t) atomic_load(&server->num_no_path), (uint64_t) atomic_load(&server->num_bad),
+        num_values ? atomic_load(&latencies->sum) / 1e3 / num_values : 0.0,
+        get_percentile(latencies, 50) / 1e3, get_percentile(latencies, 90) / 1e3,
+        get_percentile(latencies, 99) / 1e3, get_percentile(latencies, 99.9) / 1e3,
+        atomic_load(&latencies->max) / 1e3);
+
+    if (reset) {
+        clear_histogram(latencies);
+        atomic_store(&server->num_queries, 0);
+        atomic_store(&server->num_no_path, 0);
+        atomic_store(&server->num_bad, 0);
+    }
+    return (len < size) ? len : size - 1;
+}
+
+void send_response(Server* server, ServerJob* job, ServerResponse* response, void* payload,
+    uint32_t payload_size) {
+    /* Counts a query and its latency (stats requests aren't counted), then writes its response
+    and payload to the job's connection. Counting first means a client that has read its last
+    answer and asks for the stats always finds that query in them. A write that times out (see
+    SERVER_SEND_TIMEOUT) drops the connection, so its later responses fail at once. */
+
+    if (job->request.type == SERVER_QUERY) {
+        atomic_fetch_add(&server->num_queries, 1);
+        if (response->status == SERVER_NO_PATH) {
+            atomic_fetch_add(&server->num_no_path, 1);
+        } else if (response->status == SERVER_BAD_REQUEST) {
+            atomic_fetch_add(&server->num_bad, 1);
+        }
+        add_to_histogram(&server->latencies, (uint64_t) ((get_time() - job->read_time) * 1e9));
+    }
+
+    response->length = sizeof *(response) - sizeof response->length + payload_size;
+    Connection* connection = job->connection;
+    pthread_mutex_lock(&connection->write_lock);
+    if (write_full(connection->fd, response, sizeof *(response)) == -1 ||
+        (payload_size > 0 && write_full(connection->fd, payload, payload_size) == -1)) {
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&connection->write_lock);
+}
@@ -0,0 +1,165 @@
+// Counts and timings of a run, printed as a one-line JSON report at its end with --stats, so runs
+// of different builds can be compared. Every search keeps its counts as plain fields that are
+// always updated (see Search, Heap and HpaSearch), so the report costs nothing to collect.
+//
+// The report's keys:
+//  - map, rows, cols, mode ("astar", "jps", "bidir", "hpa", "hda", "flow" or "ara"), open_list
+//    ("heap" or "bucket"), moves ("4", "8" or "8-no-corners"), landmarks, queries and threads
+//    describe the run.
+//  - paths_found is the number of queries with a path, and path_cost the sum of their costs.
+//  - load_s is the time taken to load the map and build whatever the mode needs from it
+//    (components, jump map, landmarks, abstract graph), search_s the time spent searching, and
+//    reconstruct_s the time spent following the path back and marking it on the map.
+//  - nodes_expanded, reopenings (closed nodes given a shorter path and opened again),
+//    decrease_keys (nodes still open given a shorter path), open_list_pushes, open_list_pops and
+//    sift_levels (levels moved by nodes sifting up and down the open list's heaps) are summed over
+//    every query, while max_sift_depth and peak_open_nodes are the largest over every query (for a
+//    bidirectional search, the peaks of its two sides are added together, and for HDA* those of
+//    all of its threads).
+
+#include <time.h>
+#include <inttypes.h>
+
+// The counts of one or more searches.
+typedef struct {
+    int64_t num_expanded;
+    int64_t num_reopened;
+    int64_t num_decreased;
+    int64_t num_pushes;
+    int64_t num_pops;
+    int64_t num_sift_levels;
+    int max_sift_depth;
+    int peak_open_nodes;
+} Counts;
+
+typedef struct {
+    char* map_name;
+    int num_rows;
+    int num_cols;
+    char* mode;
+    int backend;
+    int moves;
+    int landmarks;
+    int num_queries;
+    int num_threads;
+    int num_paths;
+    int64_t path_cost;
+    double load_time;
+    double search_time;
+    double reconstruct_time;
+    Counts counts;
+} Stats;
+
+// Function declarations --------------------------------------------------------------------------
+
+void init_stats(Stats* stats, char* map_name, char* mode, int backend, int landmarks);
+void get_search_counts(Search* search, Counts* counts);
+void get_bidirectional_counts(Search* forward, Search* backward, Counts* counts);
+void add_counts(Counts* total, Counts* counts);
+void add_path(Stats* stats, int path_cost, Counts* counts);
+void print_stats(Stats* stats);
+void print_json_string(char* string);
+double get_time();
+
+// Function declarations end ----------------------------------------------------------------------
+
+void init_stats(Stats* stats, char* map_name, char* mode, int backend, int landmarks) {
+    memset(stats, 0, sizeof *(stats));
+    stats->map_name = map_name;
+    stats->mode = mode;
+    stats->backend = backend;
+    stats->landmarks = landmarks;
+    stats->moves = MOVES_8;
+    stats->num_threads = 1;
+}
+
+void get_search_counts(Search* search, Counts* counts) {
+    // Saves the counts of the last search run over a Search into counts.
+    counts->num_expanded = search->num_expanded;
+    counts->num_reopened = search->num_reopened;
+    counts->num_decreased = search->num_decreased;
+    counts->num_pushes = search->open_nodes.num_pushes;
+    counts->num_pops = search->open_nodes.num_pops;
+    counts->num_sift_levels = search->open_nodes.num_sift_levels;
+    counts->max_sift_depth = search->open_nodes.max_sift_depth;
+    counts->peak_open_nodes = search->open_nodes.peak_open_nodes;
+}
+
+void get_bidirectional_counts(Search* forward, Search* backward, Counts* counts) {
+    // Like get_search_counts, for both sides of a bidirectional search.
+    Counts backward_counts;
+    get_search_counts(forward, counts);
+    get_search_counts(backward, &backward_counts);
+    int peak_open_nodes = counts->peak_open_nodes + backward_counts.peak_open_nodes;
+    add_counts(counts, &backward_counts);
+    counts->peak_open_nodes = peak_open_nodes;
+}
+
+void add_counts(Counts* total, Counts* counts) {
+    // Adds the counts of another search to total, keeping the larger of the two peaks.
+    total->num_expanded += counts->num_expanded;
+    total->num_reopened += counts->num_reopened;
+    total->num_decreased += counts->num_decreased;
+    total->num_pushes += counts->num_pushes;
+    total->num_pops += counts->num_pops;
+    total->num_sift_levels += counts->num_sift_levels;
+    if (counts->max_sift_depth > total->max_sift_depth) {
+        total->max_sift_depth = counts->max_sift_depth;
+    }
+    if (counts->peak_open_nodes > total->peak_open_nodes) {
+        total->peak_open_nodes = counts->peak_open_nodes;
+    }
+}
+
+void add_path(Stats* stats, int path_cost, Counts* counts) {
+    // Adds the result and counts of one query to the report.
+    stats->num_queries++;
+    if (path_cost != -1) {
+        stats->num_paths++;
+        stats->path_cost += path_cost;
+    }
+    add_counts(&stats->counts, counts);
+}
+
+void print_stats(Stats* stats) {
+    Counts* counts = &stats->counts;
+    printf("{\"map\": ");
+    print_json_string(stats->map_name);
+    printf(", \"rows\": %d, \"cols\": %d, \"mode\": \"%s\", \"open_list\": \"%s\", "
+        "\"moves\": \"%s\", \"landmarks\": %s, \"queries\": %d, \"threads\": %d, "
+        "\"paths_found\": %d, \"path_cost\": %" PRId64 ", ", stats->num_rows, stats->num_cols,
+        stats->mode, (stats->backend == BUCKET_QUEUE) ? "bucket" : "heap",
+        (stats->moves == MOVES_4) ? "4" : (stats->moves == MOVES_8) ? "8" : "8-no-corners",
+        stats->landmarks ? "true" : "false", stats->num_queries, stats->num_threads,
+        stats->num_paths, stats->path_cost);
+    printf("\"load_s\": %.6f, \"search_s\": %.6f, \"reconstruct_s\": %.6f, ", stats->load_time,
+        stats->search_time, stats->reconstruct_time);
+    printf("\"nodes_expanded\": %" PRId64 ", \"reopenings\": %" PRId64 ", "
+        "\"decrease_keys\": %" PRId64 ", \"open_list_pushes\": %" PRId64 ", "
+        "\"open_list_pops\": %" PRId64 ", \"sift_levels\": %" PRId64 ", \"max_sift_depth\": %d, "
+        "\"peak_open_nodes\": %d}\n",
+        counts->num_expanded, counts->num_reopened, counts->num_decreased, counts->num_pushes,
+        counts->num_pops, counts->num_sift_levels, counts->max_sift_depth, counts->peak_open_nodes);
+}
+
+void print_json_string(char* string) {
+    // Prints a string as a quoted JSON string, escaping what JSON doesn't allow as is.
+    putchar('"');
+    for (; *string; string++) {
+        if (*string == '"' || *string == '\\') {
+            printf("\\%c", *string);
+        } else if ((unsigned char) *string < ' ') {
+            printf("\\u%04x", (unsigned char) *string);
+        } else {
+            putchar(*string);
+        }
+    }
+    putchar('"');
+}
+
+double get_time() {
+    // Returns the time in seconds from a monotonic clock.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -1,93 +1,93 @@
 // Author:          Alexander M. Terp
 // Creation date:   2016-08-25
-// Purpose:         Demonstrates what is dubbed the "end sort" sorting 
+// Purpose:         Demonstrates what is dubbed the "end sort" sorting
 //                  algorithm, a divide and conquer approach of O(nlogn).
+//                  Sorts the numbers given on standard input with it and with
+//                  C's inbuilt qsort (like qsort.c), checks that both sorted
+//                  them the same way and prints how long each took. Given a
+//                  number of threads (e.g. ./endsort 8), end sort runs on
+//                  that many at once.
+
+#define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "endsort.h"
+#include "parallel_endsort.h"
 
 #define NORMAL "\x1B[0m"
 #define LIGHT_RED "\x1B[1;31m"
 
-#define ITEMS 23       // Number of items to be sorted
-#define MAX_ITEM_LEN 3      // Length of the longest numbers (for printing purposes)
-#define MAX_CYCLES 17 // The max numbers of cycles of the algorithm that are applied.
+#define INIT_ITEMS 1024   // Numbers read are stored in an array that starts this big.
+#define MAX_PRINTED 64    // Arrays longer than this aren't printed.
 
-void recurs_endsort(int array[], int n, int start, int big_left);
-void single_endsort(int array[], int numel, int start);
-void swap(int *pointer1, int *pointer2);
+int* read_numbers(int* n);
+int cmpfunc(const void * a, const void * b);
+double get_time(void);
 void print_array(int array[], int n, int swap1, int swap2);
 int get_correctness(int array[], int n);
 
-int main(void) {
-    int* array = malloc(sizeof(int) * ITEMS);
-    int i, num_correct = 0, cycles = 0;
-    for (i = 0; i < ITEMS; i++) {
-        //printf("%d\n", i);
-        scanf("%d", &array[i]);
+int main(int argc, char* argv[]) {
+    int num_threads = (argc > 1) ? atoi(argv[1]) : 1;
+    int n;
+    int* array = read_numbers(&n);
+    int* copy = malloc(sizeof(int) * (n ? n : 1));
+    memcpy(copy, array, sizeof(int) * n);
+    if (n <= MAX_PRINTED) {
+        print_array(array, n, -1, -1);
     }
-    //print_array(array, ITEMS, -1, -1);
+    get_correctness(array, n);
 
-    get_correctness(array, ITEMS);
-    while (num_correct < ITEMS-1 && cycles < MAX_CYCLES) {
-        //printf("NEW CYCLE!\n");
-        single_endsort(array, ITEMS, 0);
-        recurs_endsort(array, ITEMS, 0, cycles % 2);
-        num_correct = get_correctness(array, ITEMS);
-        cycles++;
-    }
-    //get_correctness(array, ITEMS);
-    //print_array(array, ITEMS, -1, -1);
+    double start = get_time();
+    parallel_endsort(array, n, num_threads);
+    double endsort_time = get_time() - start;
 
-    return 0;
-}
+    start = get_time();
+    qsort(copy, n, sizeof(int), cmpfunc);
+    double qsort_time = get_time() - start;
 
-void recurs_endsort(int array[], int numel, int start, int big_left) {
-    // Enacts a cycle of what is dubbed the "endsort" sorting algorithm.
-    // Acts recursively.
-    //printf("New call | numel: %2d | start: %2d | big_left: %d\n", numel, start, big_left);
-    
-    if (numel == 1 || numel == 0) {
-        return;
+    if (n <= MAX_PRINTED) {
+        print_array(array, n, -1, -1);
     }
-
-    int half = (numel + big_left) / 2;
-    int odd_numel = numel % 2;
-
-    //printf("F1 | ITEMS: %d | START: %d\n", half, start);
-    single_endsort(array, half, start);
-    //printf("F2 | ITEMS: %d | START: %d\n", numel - half, start + half);
-    single_endsort(array, numel - half, start + half);
-    if (odd_numel) {
-        //printf("F3 | ITEMS: %d | START: %d\n", numel - half, start);
-        single_endsort(array, numel - half, start);
-        //printf("F4 | ITEMS: %d | START: %d\n", half, numel - half);
-        single_endsort(array, half, start + numel - half);
+    int num_correct = get_correctness(array, n);
+    if (memcmp(array, copy, sizeof(int) * n) != 0 || (n > 1 && num_correct < n - 1)) {
+        printf("End sort and qsort disagree!\n");
+        return 1;
     }
 
-    //wait(1);
-    recurs_endsort(array, numel - half, start, big_left);
-    recurs_endsort(array, half, start + numel - half, big_left);
+    printf("%d numbers | End sort (%d thread%s): %lf s | qsort: %lf s\n", n, num_threads,
+           (num_threads == 1) ? "" : "s", endsort_time, qsort_time);
+    free(array);
+    free(copy);
+    return 0;
 }
 
-void single_endsort(int array[], int numel, int start) {
-    int i, j;
-    for (i = start, j = start + numel-1; i < (start + numel/2); i++, j--) {
-        //printf("Comparing %d and %d\n", array[i], array[j]);
-        if (array[i] > array[j]) {
-            //printf("Swap %3d and %3d | \t\t", array[i], array[j]);
-            //print_array(array, ITEMS, i, j);
-            swap(&array[i], &array[j]);
+int* read_numbers(int* n) {
+    // Reads every number on standard input into an array, saving how many there were into n.
+    int size = INIT_ITEMS;
+    int* array = malloc(sizeof(int) * size);
+    *n = 0;
+    while (scanf("%d", &array[*n]) == 1) {
+        if (++(*n) == size) {
+            size *= 2;
+            array = realloc(array, sizeof(int) * size);
         }
     }
+    return array;
 }
 
-void swap(int *pointer1, int *pointer2) {
-    // Swap the values of two integer pointers.
-    //printf("s");
-    int temp = *pointer1;
-    *pointer1 = *pointer2;
-    *pointer2 = temp;
+int cmpfunc(const void * a, const void * b) {
+    // Compares without subtracting, which could overflow for numbers far apart.
+    int x = *(int*)a, y = *(int*)b;
+    return (x > y) - (x < y);
+}
+
+double get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
 }
 
 void print_array(int array[], int n, int swap1, int swap2) {
@@ -117,8 +117,8 @@ int get_correctness(int array[], int n) {
             amount_correct++;
         }
     }
-    double percentage_correct =  (double) amount_correct / (n - 1);
-    printf("\nCycle %2d | Amount correct: %3d | %% Correct: %lf\n", 
+    double percentage_correct = (n > 1) ? (double) amount_correct / (n - 1) : 1;
+    printf("\nCycle %2d | Amount correct: %3d | %% Correct: %lf\n",
            cycles++, amount_correct, percentage_correct);
     return amount_correct;
-}
\ No newline at end of file
+}
@@ -0,0 +1,450 @@
+// The "end sort" sorting algorithm as a sorting network, used by endsort.c.
+//
+// An end sort pass (single_endsort) compares the numbers at opposite ends of a range and swaps
+// them if they're out of order, working in towards the middle. The comparisons made never depend
+// on the numbers, which makes end sort a sorting network, and the pass is exactly the first step
+// of merging two sorted halves in a bitonic sorter: afterwards every number in the lower half is
+// at most every number in the upper half, and both halves are bitonic (they rise, then fall). The
+// original version then repeated end sort passes on each half, which doesn't sort bitonic halves
+// and is why it could get stuck. A bitonic half is sorted by comparing each number with the one
+// half of the half above it (clean_endsort), then again within each quarter, and so on. So:
+//  - recurs_endsort sorts both halves first, then does one end sort pass and cleans each half.
+//  - This takes (log n)(log n + 1) / 2 passes of n / 2 comparisons each, for n a power of 2.
+//
+// The comparisons of a pass are independent of each other, so they can be done several at a time
+// with SIMD min/max instructions. Numbers are sorted in blocks of BLOCK_INTS (32) that fit in
+// registers: AVX2 registers hold 8 numbers, so a block is 4 of them, and SSE registers hold 4, so
+// a block is 8 of them. Passes over whole registers are a min and a max of two of them, while
+// passes within a register swap its numbers around with a shuffle and take the min or max of
+// each pair with a blend. End sort passes reverse the upper register's numbers first.
+//
+// Large arrays are sorted as blocks, which are then merged two runs at a time, doubling the length
+// of the sorted runs each round until one is left. Runs are merged MERGE_INTS numbers at a time
+// by the same network: the next MERGE_INTS numbers of whichever run has the smaller one next are
+// merged with the largest MERGE_INTS numbers of the last merge, and the lower half is output. The
+// whole sort then takes O(n log n) comparisons instead of the O(n log^2 n) of a pure network.
+//
+// Build with -mavx2 or -msse4.1 (or -march=native) to use the vector kernels. Without either, the
+// blocks are sorted by the scalar network and runs merged one number at a time.
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    #include <immintrin.h>
+#endif
+
+#define BLOCK_INTS 32 // The numbers sorted at once in registers. A power of 2.
+#define MERGE_INTS 16 // The numbers output by each step of a merge. Half of BLOCK_INTS at most.
+
+#if defined(__AVX2__)
+    #define VEC_INTS 8
+    typedef __m256i Vec;
+#elif defined(__SSE4_1__)
+    #define VEC_INTS 4
+    typedef __m128i Vec;
+#endif
+#ifdef VEC_INTS
+    #define BLOCK_VECS (BLOCK_INTS / VEC_INTS)
+    #define MERGE_VECS (MERGE_INTS / VEC_INTS)
+#endif
+
+// If set, end sort adds the number of comparisons it makes to it: every compare-exchange of the
+// network, and every comparison choosing which run to merge from next. Used by sortbench.c, and
+// only for sorts on one thread.
+long long* endsort_comparisons = NULL;
+
+void endsort(int array[], int n);
+void sort_blocks(int array[], int n);
+int* merge_runs(int array[], int buffer[], int n, int run_len);
+void merge_two_runs(int run1[], int len1, int run2[], int len2, int out[]);
+void recurs_endsort(int array[], int numel, int start);
+void single_endsort(int array[], int numel, int start);
+void clean_endsort(int array[], int numel, int start);
+void compare_swap(int *pointer1, int *pointer2);
+long long get_network_comparisons(int numel);
+long long get_clean_comparisons(int numel);
+#ifdef VEC_INTS
+static inline Vec vec_load(int* pointer);
+static inline void vec_store(int* pointer, Vec vec);
+static inline Vec vec_min(Vec a, Vec b);
+static inline Vec vec_max(Vec a, Vec b);
+static inline Vec vec_reverse(Vec vec);
+static inline Vec sort_vec(Vec vec);
+static inline Vec clean_vec(Vec vec);
+static inline void sort_vecs(Vec vecs[], int num_vecs);
+static inline void merge_vecs(Vec vecs[], int num_vecs);
+static inline void clean_vecs(Vec vecs[], int num_vecs);
+static inline void load_chunk(Vec vecs[], int* pointer, int num_left);
+static inline void store_chunk(int* pointer, Vec vecs[], int num_left);
+#endif
+
+void endsort(int array[], int n) {
+    // Sorts an array of n numbers into ascending order.
+    if (n <= 1) {
+        return;
+    }
+
+    int* buffer = malloc(sizeof(int) * n);
+    sort_blocks(array, n);
+    int* sorted = merge_runs(array, buffer, n, BLOCK_INTS);
+    if (sorted != array) {
+        memcpy(array, sorted, sizeof(int) * n);
+    }
+    free(buffer);
+}
+
+void sort_blocks(int array[], int n) {
+    // Sorts each block of BLOCK_INTS numbers of an array. A last, shorter block is sorted in a
+    // copy padded with INT_MAX, which sorts to the end, past the numbers copied back.
+    for (int start = 0; start < n; start += BLOCK_INTS) {
+        int padded[BLOCK_INTS];
+        int* block = &array[start];
+        if (n - start < BLOCK_INTS) {
+            block = padded;
+            for (int i = 0; i < BLOCK_INTS; i++) {
+                padded[i] = (start + i < n) ? array[start + i] : INT_MAX;
+            }
+        }
+
+#ifdef VEC_INTS
+        Vec vecs[BLOCK_VECS];
+        for (int i = 0; i < BLOCK_VECS; i++) {
+            vecs[i] = vec_load(&block[i * VEC_INTS]);
+        }
+        sort_vecs(vecs, BLOCK_VECS);
+        for (int i = 0; i < BLOCK_VECS; i++) {
+            vec_store(&block[i * VEC_INTS], vecs[i]);
+        }
+#else
+        recurs_endsort(block, BLOCK_INTS, 0);
+#endif
+
+        if (block == padded) {
+            memcpy(&array[start], padded, sizeof(int) * (n - start));
+        }
+    }
+
+    if (endsort_comparisons != NULL) {
+        long long num_blocks = (n + BLOCK_INTS - 1) / BLOCK_INTS;
+        *endsort_comparisons += num_blocks * get_network_comparisons(BLOCK_INTS);
+    }
+}
+
+int* merge_runs(int array[], int buffer[], int n, int run_len) {
+    // Merges the sorted runs of run_len numbers of an array of n numbers (the last run can be
+    // shorter), two at a time, back and forth between it and a buffer of the same size until it is
+    // one run. Returns whichever of the two holds the sorted numbers.
+    int* from = array;
+    int* to = buffer;
+    for (; run_len < n; run_len *= 2) {
+        for (int start = 0; start < n; start += 2 * run_len) {
+            if (start + run_len >= n) {
+                // The last run has nothing to merge with.
+                memcpy(&to[start], &from[start], sizeof(int) * (n - start));
+            } else {
+                int len2 = (start + 2 * run_len <= n) ? run_len : n - start - run_len;
+                merge_two_runs(&from[start], run_len, &from[start + run_len], len2, &to[start]);
+            }
+        }
+        int* temp = from;
+        from = to;
+        to = temp;
+    }
+    return from;
+}
+
+void merge_two_runs(int run1[], int len1, int run2[], int len2, int out[]) {
+    // Merges two sorted runs of any length into out.
+    if (len1 == 0 || len2 == 0) {
+        memcpy(out, run1, sizeof(int) * len1);
+        memcpy(out + len1, run2, sizeof(int) * len2);
+        return;
+    }
+
+#ifdef VEC_INTS
+    // The last numbers of a run are loaded padded with INT_MAX up to MERGE_INTS. The padding
+    // sorts to the end, and only the first len1 + len2 numbers merged are output; any INT_MAX
+    // output in place of one of the run's own is the same number.
+    Vec vecs[2 * MERGE_VECS];
+    load_chunk(vecs, run1, len1);
+    load_chunk(vecs + MERGE_VECS, run2, len2);
+
+    int i1 = MERGE_INTS, i2 = MERGE_INTS, num_left = len1 + len2;
+    long long num_steps = 0, num_choices = 0;
+    for (;;) {
+        // Both halves are sorted, so merging them is one end sort pass and cleaning each half.
+        merge_vecs(vecs, 2 * MERGE_VECS);
+        num_steps++;
+        store_chunk(out, vecs, num_left);
+        out += MERGE_INTS;
+        num_left -= MERGE_INTS;
+        if (num_left <= 0) {
+            break;
+        }
+
+        // The upper half stays, to be merged with the next numbers of the run whose next number
+        // is smaller. Those can't be smaller than anything output so far.
+        num_choices += (i1 < len1 && i2 < len2);
+        if (i1 < len1 && (i2 >= len2 || run1[i1] <= run2[i2])) {
+            load_chunk(vecs, &run1[i1], len1 - i1);
+            i1 += MERGE_INTS;
+        } else if (i2 < len2) {
+            load_chunk(vecs, &run2[i2], len2 - i2);
+            i2 += MERGE_INTS;
+        } else {
+            store_chunk(out, vecs + MERGE_VECS, num_left);
+            break;
+        }
+    }
+
+    if (endsort_comparisons != NULL) {
+        // Each step merges two sorted halves: one end sort pass, and cleaning each half.
+        long long step_comparisons = MERGE_INTS + 2 * get_clean_comparisons(MERGE_INTS);
+        *endsort_comparisons += num_steps * step_comparisons + num_choices;
+    }
+#else
+    int i1 = 0, i2 = 0;
+    while (i1 < len1 && i2 < len2) {
+        *out++ = (run2[i2] < run1[i1]) ? run2[i2++] : run1[i1++];
+    }
+    if (endsort_comparisons != NULL) {
+        *endsort_comparisons += i1 + i2;
+    }
+    memcpy(out, &run1[i1], sizeof(int) * (len1 - i1));
+    memcpy(out + len1 - i1, &run2[i2], sizeof(int) * (len2 - i2));
+#endif
+}
+
+void recurs_endsort(int array[], int numel, int start) {
+    // Sorts numel numbers of an array from start with the end sort network. numel must be a
+    // power of 2.
+    if (numel <= 1) {
+        return;
+    }
+
+    int half = numel / 2;
+    recurs_endsort(array, half, start);
+    recurs_endsort(array, half, start + half);
+    single_endsort(array, numel, start);
+    clean_endsort(array, half, start);
+    clean_endsort(array, half, start + half);
+}
+
+void single_endsort(int array[], int numel, int start) {
+    // Compares each number of a range with the one at the same distance from its other end,
+    // leaving the smaller one in the lower half.
+    int i, j;
+    for (i = start, j = start + numel-1; i < (start + numel/2); i++, j--) {
+        compare_swap(&array[i], &array[j]);
+    }
+}
+
+void clean_endsort(int array[], int numel, int start) {
+    // Sorts a bitonic range of numel numbers (a power of 2): compares each number in its lower
+    // half with the one half the range above it, then does the same within each half, each
+    // quarter, and so on.
+    for (int half = numel / 2; half >= 1; half /= 2) {
+        for (int block = start; block < start + numel; block += 2 * half) {
+            for (int i = block; i < block + half; i++) {
+                compare_swap(&array[i], &array[i + half]);
+            }
+        }
+    }
+}
+
+void compare_swap(int *pointer1, int *pointer2) {
+    // Puts the smaller of two numbers in the first one, and the larger in the second.
+    int a = *pointer1, b = *pointer2;
+    *pointer1 = (a < b) ? a : b;
+    *pointer2 = (a < b) ? b : a;
+}
+
+long long get_network_comparisons(int numel) {
+    // Returns the compare-exchanges recurs_endsort makes on numel numbers (a power of 2).
+    if (numel <= 1) {
+        return 0;
+    }
+    int half = numel / 2;
+    return 2 * get_network_comparisons(half) + half + 2 * get_clean_comparisons(half);
+}
+
+long long get_clean_comparisons(int numel) {
+    // Returns the compare-exchanges clean_endsort makes on numel numbers (a power of 2).
+    long long comparisons = 0;
+    for (int half = numel / 2; half >= 1; half /= 2) {
+        comparisons += numel / 2;
+    }
+    return comparisons;
+}
+
+#if defined(__AVX2__)
+
+static inline Vec vec_load(int* pointer) {
+    return _mm256_loadu_si256((__m256i*) pointer);
+}
+
+static inline void vec_store(int* pointer, Vec vec) {
+    _mm256_storeu_si256((__m256i*) pointer, vec);
+}
+
+static inline Vec vec_min(Vec a, Vec b) {
+    return _mm256_min_epi32(a, b);
+}
+
+static inline Vec vec_max(Vec a, Vec b) {
+    return _mm256_max_epi32(a, b);
+}
+
+static inline Vec vec_reverse(Vec vec) {
+    return _mm256_permutevar8x32_epi32(vec, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+static inline Vec sort_vec(Vec vec) {
+    // Sorts the 8 numbers of a register: end sort passes over pairs, fours (then cleaning each
+    // pair) and all eight (then cleaning each four). Each pass pairs every number with another
+    // by shuffling, and the blend mask sets the lanes that keep the larger of the two.
+    Vec other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xAA);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(0, 1, 2, 3));
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xCC);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xAA);
+    other = vec_reverse(vec);
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xF0);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(1, 0, 3, 2));
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xCC);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xAA);
+}
+
+static inline Vec clean_vec(Vec vec) {
+    // Sorts the 8 numbers of a bitonic register, comparing numbers 4, 2 and 1 lanes apart.
+    Vec other = _mm256_permute2x128_si256(vec, vec, 1);
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xF0);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(1, 0, 3, 2));
+    vec = _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xCC);
+    other = _mm256_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_blend_epi32(vec_min(vec, other), vec_max(vec, other), 0xAA);
+}
+
+#elif defined(__SSE4_1__)
+
+static inline Vec vec_load(int* pointer) {
+    return _mm_loadu_si128((__m128i*) pointer);
+}
+
+static inline void vec_store(int* pointer, Vec vec) {
+    _mm_storeu_si128((__m128i*) pointer, vec);
+}
+
+static inline Vec vec_min(Vec a, Vec b) {
+    return _mm_min_epi32(a, b);
+}
+
+static inline Vec vec_max(Vec a, Vec b) {
+    return _mm_max_epi32(a, b);
+}
+
+static inline Vec vec_reverse(Vec vec) {
+    return _mm_shuffle_epi32(vec, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static inline Vec sort_vec(Vec vec) {
+    // Sorts the 4 numbers of a register: end sort passes over pairs and all four, then cleaning
+    // each pair (see the AVX2 version).
+    Vec other = _mm_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    vec = _mm_blend_epi16(vec_min(vec, other), vec_max(vec, other), 0xCC);
+    other = vec_reverse(vec);
+    vec = _mm_blend_epi16(vec_min(vec, other), vec_max(vec, other), 0xF0);
+    other = _mm_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_blend_epi16(vec_min(vec, other), vec_max(vec, other), 0xCC);
+}
+
+static inline Vec clean_vec(Vec vec) {
+    // Sorts the 4 numbers of a bitonic register, comparing numbers 2 and 1 lanes apart. The blend
+    // masks are of 16-bit halves, so two bits per number.
+    Vec other = _mm_shuffle_epi32(vec, _MM_SHUFFLE(1, 0, 3, 2));
+    vec = _mm_blend_epi16(vec_min(vec, other), vec_max(vec, other), 0xF0);
+    other = _mm_shuffle_epi32(vec, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_blend_epi16(vec_min(vec, other), vec_max(vec, other), 0xCC);
+}
+
+#endif
+
+#ifdef VEC_INTS
+
+static inline void sort_vecs(Vec vecs[], int num_vecs) {
+    // Sorts the numbers of num_vecs registers (a power of 2), in order of the registers.
+    if (num_vecs == 1) {
+        vecs[0] = sort_vec(vecs[0]);
+        return;
+    }
+    sort_vecs(vecs, num_vecs / 2);
+    sort_vecs(vecs + num_vecs / 2, num_vecs / 2);
+    merge_vecs(vecs, num_vecs);
+}
+
+static inline void merge_vecs(Vec vecs[], int num_vecs) {
+    // Sorts the numbers of num_vecs registers (a power of 2 above 1) whose two halves are sorted.
+    // The end sort pass puts the larger numbers of the upper half in it in reverse, which is as
+    // bitonic as putting them back in order, and saves reversing them again.
+    Vec upper[BLOCK_VECS / 2];
+    for (int i = 0; i < num_vecs / 2; i++) {
+        Vec other = vec_reverse(vecs[num_vecs - 1 - i]);
+        upper[i] = vec_max(vecs[i], other);
+        vecs[i] = vec_min(vecs[i], other);
+    }
+    for (int i = 0; i < num_vecs / 2; i++) {
+        vecs[num_vecs / 2 + i] = upper[i];
+    }
+    clean_vecs(vecs, num_vecs / 2);
+    clean_vecs(vecs + num_vecs / 2, num_vecs / 2);
+}
+
+static inline void clean_vecs(Vec vecs[], int num_vecs) {
+    // Sorts the numbers of num_vecs bitonic registers: passes over whole registers until each
+    // is compared with the one next to it, then within each one.
+    for (int half = num_vecs / 2; half >= 1; half /= 2) {
+        for (int block = 0; block < num_vecs; block += 2 * half) {
+            for (int i = block; i < block + half; i++) {
+                Vec lower = vecs[i];
+                vecs[i] = vec_min(lower, vecs[i + half]);
+                vecs[i + half] = vec_max(lower, vecs[i + half]);
+            }
+        }
+    }
+    for (int i = 0; i < num_vecs; i++) {
+        vecs[i] = clean_vec(vecs[i]);
+    }
+}
+
+static inline void load_chunk(Vec vecs[], int* pointer, int num_left) {
+    // Loads the next MERGE_INTS numbers of a run with num_left numbers left, padding it with
+    // INT_MAX if it has fewer.
+    int padded[MERGE_INTS];
+    if (num_left < MERGE_INTS) {
+        for (int i = 0; i < MERGE_INTS; i++) {
+            padded[i] = (i < num_left) ? pointer[i] : INT_MAX;
+        }
+        pointer = padded;
+    }
+    for (int i = 0; i < MERGE_VECS; i++) {
+        vecs[i] = vec_load(&pointer[i * VEC_INTS]);
+    }
+}
+
+static inline void store_chunk(int* pointer, Vec vecs[], int num_left) {
+    // Stores MERGE_INTS numbers into an output with room for num_left more, or as many as fit.
+    int padded[MERGE_INTS];
+    int* to = (num_left < MERGE_INTS) ? padded : pointer;
+    for (int i = 0; i < MERGE_VECS; i++) {
+        vec_store(&to[i * VEC_INTS], vecs[i]);
+    }
+    if (to == padded) {
+        memcpy(pointer, padded, sizeof(int) * num_left);
+    }
+}
+
+#endif
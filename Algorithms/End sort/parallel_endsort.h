@@ -0,0 +1,271 @@
+// End sort (see endsort.h) on several threads at once.
+//
+// The sort splits an array in half, sorts each half, then merges them. The two halves are
+// disjoint, so they can be sorted at the same time, and so on down the recursion until the ranges
+// are SERIAL_CUTOFF numbers or fewer, which are sorted by one thread like endsort does. Merges are
+// split up too, or the last one alone would take as long as sorting the whole array on one thread
+// takes to read it: the output is cut in half, and the numbers of each run that end up in its
+// lower half are found by a binary search, so the two halves are merged at the same time.
+//
+// Work is spread over the threads by work stealing. Each thread has a deque of tasks (ranges to
+// sort or merge). Splitting a range pushes one half onto the bottom of the thread's own deque and
+// does the other half straight away, then waits for the pushed half. A thread with nothing to do
+// steals from the top of another thread's deque, which holds the oldest, and so largest, tasks it
+// has pushed. A thread waiting for a task pops it back off its own deque and does it if it hasn't
+// been stolen, and otherwise helps by doing other tasks until it is done, so threads never block.
+// Each deque has a lock, only ever held for a push, pop or steal.
+//
+// Build with -pthread.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define SERIAL_CUTOFF (1 << 16) // Ranges of this many numbers or fewer are sorted by one thread.
+#define MAX_TASKS 1024          // The tasks each deque can hold. Tasks beyond it are done at once.
+
+#define SORT_TASK 0
+#define MERGE_TASK 1
+
+typedef struct {
+    int kind;
+    int* data;          // SORT_TASK: sorts data, and leaves it in buffer if to_buffer is set.
+    int* buffer;
+    int n;
+    int to_buffer;
+    int* run1;          // MERGE_TASK: merges run1 and run2 into out.
+    int len1;
+    int* run2;
+    int len2;
+    int* out;
+    atomic_int done;
+} Task;
+
+typedef struct {
+    Task* tasks[MAX_TASKS];
+    int top;            // The oldest task, the next one stolen.
+    int bottom;         // One past the newest task.
+    pthread_mutex_t lock;
+} TaskDeque;
+
+typedef struct {
+    TaskDeque* deques;
+    int num_threads;
+    atomic_int stop;
+} TaskPool;
+
+typedef struct {
+    TaskPool* pool;
+    int id;
+    unsigned seed;      // For picking threads to steal from.
+} Worker;
+
+void parallel_endsort(int array[], int n, int num_threads);
+void* pool_worker(void* arg);
+void sort_range(Worker* worker, int data[], int buffer[], int n, int to_buffer);
+void merge_range(Worker* worker, int run1[], int len1, int run2[], int len2, int out[]);
+int split_runs(int run1[], int len1, int run2[], int len2, int k);
+void run_task(Worker* worker, Task* task);
+void spawn_task(Worker* worker, Task* task);
+void wait_task(Worker* worker, Task* task);
+Task* find_task(Worker* worker);
+Task* pop_task(TaskDeque* deque);
+Task* steal_task(TaskDeque* deque);
+
+void parallel_endsort(int array[], int n, int num_threads) {
+    // Sorts an array of n numbers into ascending order on num_threads threads (the calling one
+    // among them).
+    if (num_threads <= 1 || n <= SERIAL_CUTOFF) {
+        endsort(array, n);
+        return;
+    }
+
+    TaskPool pool;
+    pool.num_threads = num_threads;
+    pool.deques = malloc(sizeof(TaskDeque) * num_threads);
+    atomic_init(&pool.stop, 0);
+    Worker* workers = malloc(sizeof(Worker) * num_threads);
+    pthread_t* threads = malloc(sizeof(pthread_t) * num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        pool.deques[i].top = pool.deques[i].bottom = 0;
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        workers[i].pool = &pool;
+        workers[i].id = i;
+        workers[i].seed = 2 * i + 1;
+    }
+    for (int i = 1; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, pool_worker, &workers[i]);
+    }
+
+    int* buffer = malloc(sizeof(int) * n);
+    sort_range(&workers[0], array, buffer, n, 0);
+
+    atomic_store(&pool.stop, 1);
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+    }
+    free(buffer);
+    free(threads);
+    free(workers);
+    free(pool.deques);
+}
+
+void* pool_worker(void* arg) {
+    // Does tasks taken from the other threads until the sort is done.
+    Worker* worker = arg;
+    while (!atomic_load(&worker->pool->stop)) {
+        Task* task = find_task(worker);
+        if (task != NULL) {
+            run_task(worker, task);
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void sort_range(Worker* worker, int data[], int buffer[], int n, int to_buffer) {
+    // Sorts n numbers of data, using buffer (as long) as scratch space, and leaves them sorted in
+    // data, or in buffer if to_buffer is set. The halves are sorted into the other one of the two,
+    // so that merging them puts them where they're wanted.
+    int* out = to_buffer ? buffer : data;
+    if (n <= SERIAL_CUTOFF) {
+        sort_blocks(data, n);
+        int* sorted = merge_runs(data, buffer, n, BLOCK_INTS);
+        if (sorted != out) {
+            memcpy(out, sorted, sizeof(int) * n);
+        }
+        return;
+    }
+
+    int half = n / 2;
+    Task lower = {.kind = SORT_TASK, .data = data, .buffer = buffer, .n = half,
+        .to_buffer = !to_buffer};
+    spawn_task(worker, &lower);
+    sort_range(worker, data + half, buffer + half, n - half, !to_buffer);
+    wait_task(worker, &lower);
+
+    int* from = to_buffer ? data : buffer;
+    merge_range(worker, from, half, from + half, n - half, out);
+}
+
+void merge_range(Worker* worker, int run1[], int len1, int run2[], int len2, int out[]) {
+    // Merges two sorted runs into out, splitting the output in half until it's SERIAL_CUTOFF
+    // numbers or fewer.
+    if (len1 + len2 <= SERIAL_CUTOFF) {
+        merge_two_runs(run1, len1, run2, len2, out);
+        return;
+    }
+
+    int mid = (len1 + len2) / 2;
+    int split1 = split_runs(run1, len1, run2, len2, mid);
+    int split2 = mid - split1;
+    Task lower = {.kind = MERGE_TASK, .run1 = run1, .len1 = split1, .run2 = run2, .len2 = split2,
+        .out = out};
+    spawn_task(worker, &lower);
+    merge_range(worker, run1 + split1, len1 - split1, run2 + split2, len2 - split2, out + mid);
+    wait_task(worker, &lower);
+}
+
+int split_runs(int run1[], int len1, int run2[], int len2, int k) {
+    // Returns how many of the k smallest numbers of two sorted runs are in the first one: the
+    // first i for which run1[i] would come after run2[k - i - 1], found by binary search.
+    int low = (k > len2) ? k - len2 : 0;
+    int high = (k < len1) ? k : len1;
+    while (low < high) {
+        int i = low + (high - low) / 2;
+        if (run1[i] <= run2[k - i - 1]) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+void run_task(Worker* worker, Task* task) {
+    if (task->kind == SORT_TASK) {
+        sort_range(worker, task->data, task->buffer, task->n, task->to_buffer);
+    } else {
+        merge_range(worker, task->run1, task->len1, task->run2, task->len2, task->out);
+    }
+    atomic_store(&task->done, 1);
+}
+
+void spawn_task(Worker* worker, Task* task) {
+    // Pushes a task onto the bottom of the thread's deque for it or another thread to do, or
+    // does it straight away if the deque is full.
+    atomic_init(&task->done, 0);
+    TaskDeque* deque = &worker->pool->deques[worker->id];
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom == deque->top) {
+        deque->top = deque->bottom = 0;
+    }
+    int pushed = deque->bottom < MAX_TASKS;
+    if (pushed) {
+        deque->tasks[deque->bottom++] = task;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    if (!pushed) {
+        run_task(worker, task);
+    }
+}
+
+void wait_task(Worker* worker, Task* task) {
+    // Does tasks until a task spawned by the thread is done: the task itself if it's still on the
+    // thread's deque, and otherwise any others, from its deque or stolen.
+    while (!atomic_load(&task->done)) {
+        Task* other = find_task(worker);
+        if (other != NULL) {
+            run_task(worker, other);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+Task* find_task(Worker* worker) {
+    // Returns the newest task of the thread's deque, or else one stolen from a thread picked at
+    // random (and the ones after it in turn), or NULL if there's none anywhere.
+    TaskPool* pool = worker->pool;
+    Task* task = pop_task(&pool->deques[worker->id]);
+    if (task != NULL) {
+        return task;
+    }
+
+    worker->seed = worker->seed * 1103515245 + 12345;
+    int first = (worker->seed >> 16) % pool->num_threads;
+    for (int i = 0; i < pool->num_threads; i++) {
+        int victim = (first + i) % pool->num_threads;
+        if (victim != worker->id && (task = steal_task(&pool->deques[victim])) != NULL) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+Task* pop_task(TaskDeque* deque) {
+    // Takes the newest task off the bottom of a deque, or returns NULL if it's empty.
+    Task* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        task = deque->tasks[--(deque->bottom)];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+Task* steal_task(TaskDeque* deque) {
+    // Takes the oldest task off the top of a deque, or returns NULL if it's empty.
+    Task* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        task = deque->tasks[(deque->top)++];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
@@ -4,7 +4,7 @@
 from random import randint
 import sys
 
-NUM_NUMS = 23 # Number of values to generate
+NUM_NUMS = int(sys.argv[1]) if len(sys.argv) > 1 else 23 # Number of values to generate
 MAX_NUM = NUM_NUMS * 3 # Set upper limit
 MIN_NUM = NUM_NUMS * -3 # Set lower limit
 FILE_NAME = "rand_nums.txt"
@@ -0,0 +1,358 @@
+// Purpose:         Benchmarks every sorting algorithm of this repository (end
+//                  sort on one thread and on several, z-sort, and C's inbuilt
+//                  qsort as the baseline) over the same inputs: every power of
+//                  2 from 2^4 to 2^28 numbers, in each of six distributions.
+//                  Checks that each sorted its input, and prints one line of
+//                  CSV per sort, distribution and size, with the time per
+//                  number and the comparisons and swaps made.
+//
+// Usage: sortbench [--min-log N] [--max-log N] [--sorts a,b,...] [--dists a,b,...]
+//                  [--threads T] [--max-quadratic-log N] [--min-time S]
+//
+// Build with: gcc -O2 -march=native -pthread -o sortbench sortbench.c
+//
+// Times are the average of as many runs as fit in --min-time seconds (at least one), less the
+// time to copy the input before each run. Comparisons and swaps are counted in one more run,
+// apart from the timed ones, and left empty for sorts that don't count them: qsort's swaps
+// happen inside the C library, end sort's compare-exchanges are min and max instructions rather
+// than swaps, and the parallel end sort makes the same comparisons as end sort, plus the ones
+// splitting its merges. z-sort takes time proportional to n^2, so it stops at 2^14 numbers (or
+// --max-quadratic-log).
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "endsort.h"
+#include "parallel_endsort.h"
+#include "../z-sort/z-sort.h"
+
+#define MIN_LOG 4
+#define MAX_LOG 28
+#define MAX_QUADRATIC_LOG 14 // The largest inputs sorts taking O(n^2) time are given.
+#define MIN_TIME 0.1         // Seconds of runs to average each time over.
+#define FEW_UNIQUE 8         // The number of different numbers of the few-unique inputs.
+#define NEARLY_SORTED 100    // One in this many numbers of the nearly-sorted inputs are swapped.
+
+typedef struct {
+    long long comparisons; // -1 if not counted.
+    long long swaps;       // -1 if not counted.
+} Counts;
+
+typedef struct {
+    const char* name;
+    void (*sort)(int array[], int n, Counts* counts);
+    int quadratic; // Takes O(n^2) time.
+    int threaded;  // Runs on num_threads threads.
+    int counted;   // Counts its comparisons or swaps when given a Counts.
+} Sorter;
+
+void run_endsort(int array[], int n, Counts* counts);
+void run_parallel_endsort(int array[], int n, Counts* counts);
+void run_qsort(int array[], int n, Counts* counts);
+void run_zsort(int array[], int n, Counts* counts);
+int cmpfunc(const void * a, const void * b);
+int counting_cmpfunc(const void * a, const void * b);
+void fill_input(int array[], int n, int dist, uint64_t* seed);
+uint64_t get_random(uint64_t* seed);
+uint64_t get_hash(int array[], int n);
+int is_sorted(int array[], int n);
+double time_sort(Sorter* sorter, int input[], int work[], int n, double min_time, int* reps);
+double get_time(void);
+int find_name(const char* name, const char* names[], int num_names);
+int parse_names(char* list, const char* names[], int num_names, int selected[]);
+const char* get_kernel_name(void);
+
+const char* dist_names[] = {"random", "sorted", "reversed", "few-unique", "organ-pipe",
+    "nearly-sorted"};
+#define NUM_DISTS ((int) (sizeof dist_names / sizeof *dist_names))
+
+Sorter sorters[] = {
+    {"endsort", run_endsort, 0, 0, 1},
+    {"parallel-endsort", run_parallel_endsort, 0, 1, 0},
+    {"qsort", run_qsort, 0, 0, 1},
+    {"zsort", run_zsort, 1, 0, 1},
+};
+#define NUM_SORTERS ((int) (sizeof sorters / sizeof *sorters))
+
+int num_threads;
+long long num_qsort_comparisons;
+
+int main(int argc, char* argv[]) {
+    int min_log = MIN_LOG, max_log = MAX_LOG, max_quadratic_log = MAX_QUADRATIC_LOG;
+    double min_time = MIN_TIME;
+    int selected_sorts[NUM_SORTERS], selected_dists[NUM_DISTS];
+    for (int i = 0; i < NUM_SORTERS; i++) {
+        selected_sorts[i] = 1;
+    }
+    for (int i = 0; i < NUM_DISTS; i++) {
+        selected_dists[i] = 1;
+    }
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    const char* sort_names[NUM_SORTERS];
+    for (int i = 0; i < NUM_SORTERS; i++) {
+        sort_names[i] = sorters[i].name;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-log") == 0 && i + 1 < argc) {
+            min_log = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-log") == 0 && i + 1 < argc) {
+            max_log = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-quadratic-log") == 0 && i + 1 < argc) {
+            max_quadratic_log = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--sorts") == 0 && i + 1 < argc) {
+            if (!parse_names(argv[++i], sort_names, NUM_SORTERS, selected_sorts)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--dists") == 0 && i + 1 < argc) {
+            if (!parse_names(argv[++i], dist_names, NUM_DISTS, selected_dists)) {
+                return 1;
+            }
+        } else {
+            printf("Unknown option '%s'. Usage: sortbench [--min-log N] [--max-log N] "
+                "[--sorts a,b,...] [--dists a,b,...] [--threads T] [--max-quadratic-log N] "
+                "[--min-time S]\n", argv[i]);
+            return 1;
+        }
+    }
+    if (min_log < 0 || max_log > 30 || min_log > max_log || num_threads < 1) {
+        printf("Sizes must be from 2^0 to 2^30, and threads at least 1.\n");
+        return 1;
+    }
+
+    fprintf(stderr, "# End sort kernel: %s | parallel-endsort threads: %d\n", get_kernel_name(),
+        num_threads);
+    printf("sort,distribution,n,threads,reps,ns_per_element,comparisons,swaps,correct\n");
+
+    int num_wrong = 0;
+    for (int log_n = min_log; log_n <= max_log; log_n++) {
+        int n = 1 << log_n;
+        int* input = malloc(sizeof(int) * n);
+        int* work = malloc(sizeof(int) * n);
+        if (input == NULL || work == NULL) {
+            printf("Not enough memory for 2^%d numbers.\n", log_n);
+            return 1;
+        }
+
+        for (int dist = 0; dist < NUM_DISTS; dist++) {
+            if (!selected_dists[dist]) {
+                continue;
+            }
+            uint64_t seed = 0x9E3779B97F4A7C15ULL ^ ((uint64_t) log_n << 8 | dist);
+            fill_input(input, n, dist, &seed);
+            uint64_t hash = get_hash(input, n);
+
+            for (int i = 0; i < NUM_SORTERS; i++) {
+                Sorter* sorter = &sorters[i];
+                if (!selected_sorts[i] || (sorter->quadratic && log_n > max_quadratic_log)) {
+                    continue;
+                }
+
+                int reps;
+                double seconds = time_sort(sorter, input, work, n, min_time, &reps);
+                int correct = is_sorted(work, n) && get_hash(work, n) == hash;
+                num_wrong += !correct;
+
+                Counts counts = {-1, -1};
+                if (sorter->counted) {
+                    memcpy(work, input, sizeof(int) * n);
+                    sorter->sort(work, n, &counts);
+                }
+
+                printf("%s,%s,%d,%d,%d,%.3f,", sorter->name, dist_names[dist], n,
+                    sorter->threaded ? num_threads : 1, reps, seconds / reps / n * 1e9);
+                if (counts.comparisons >= 0) {
+                    printf("%lld", counts.comparisons);
+                }
+                printf(",");
+                if (counts.swaps >= 0) {
+                    printf("%lld", counts.swaps);
+                }
+                printf(",%d\n", correct);
+                fflush(stdout);
+            }
+        }
+
+        free(input);
+        free(work);
+    }
+
+    if (num_wrong) {
+        fprintf(stderr, "# %d runs didn't sort their input!\n", num_wrong);
+    }
+    return num_wrong != 0;
+}
+
+void run_endsort(int array[], int n, Counts* counts) {
+    if (counts != NULL) {
+        counts->comparisons = 0;
+        endsort_comparisons = &counts->comparisons;
+    }
+    endsort(array, n);
+    endsort_comparisons = NULL;
+}
+
+void run_parallel_endsort(int array[], int n, Counts* counts) {
+    (void) counts; // Its counts are left empty (see the top of the file).
+    parallel_endsort(array, n, num_threads);
+}
+
+void run_qsort(int array[], int n, Counts* counts) {
+    if (counts == NULL) {
+        qsort(array, n, sizeof(int), cmpfunc);
+        return;
+    }
+    num_qsort_comparisons = 0;
+    qsort(array, n, sizeof(int), counting_cmpfunc);
+    counts->comparisons = num_qsort_comparisons;
+}
+
+void run_zsort(int array[], int n, Counts* counts) {
+    zsort(array, n, 0, (counts != NULL) ? &counts->swaps : NULL);
+    if (counts != NULL) {
+        // z-sort compares every pair of neighbors once per pass, with one fewer each pass.
+        counts->comparisons = (long long) (n - 1) * n / 2;
+    }
+}
+
+int cmpfunc(const void * a, const void * b) {
+    // Compares without subtracting, which could overflow for numbers far apart.
+    int x = *(int*)a, y = *(int*)b;
+    return (x > y) - (x < y);
+}
+
+int counting_cmpfunc(const void * a, const void * b) {
+    num_qsort_comparisons++;
+    return cmpfunc(a, b);
+}
+
+void fill_input(int array[], int n, int dist, uint64_t* seed) {
+    // Fills an array with n numbers in one of the distributions of dist_names.
+    for (int i = 0; i < n; i++) {
+        switch (dist) {
+            case 0: array[i] = (int) (get_random(seed) >> 32); break;
+            case 1: array[i] = i; break;
+            case 2: array[i] = n - 1 - i; break;
+            case 3: array[i] = get_random(seed) % FEW_UNIQUE; break;
+            case 4: array[i] = (i < n / 2) ? i : n - 1 - i; break;
+            case 5: array[i] = i; break;
+        }
+    }
+
+    if (dist == 5) {
+        // Swap random pairs, so that about one in NEARLY_SORTED numbers is out of place.
+        int num_swaps = n / NEARLY_SORTED / 2 + 1;
+        for (int i = 0; i < num_swaps && n > 1; i++) {
+            swap(&array[get_random(seed) % n], &array[get_random(seed) % n]);
+        }
+    }
+}
+
+uint64_t get_random(uint64_t* seed) {
+    // xorshift64*.
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+    return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+uint64_t get_hash(int array[], int n) {
+    // Returns a hash of the numbers of an array that doesn't depend on their order, so a sorted
+    // copy has the same hash only if it holds the same numbers (almost certainly).
+    uint64_t hash = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t x = (uint32_t) array[i];
+        x = (x ^ (x >> 16)) * 0x45D9F3B3335B369ULL;
+        x = (x ^ (x >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        hash += x ^ (x >> 32);
+    }
+    return hash;
+}
+
+int is_sorted(int array[], int n) {
+    for (int i = 0; i < n - 1; i++) {
+        if (array[i] > array[i + 1]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+double time_sort(Sorter* sorter, int input[], int work[], int n, double min_time, int* reps) {
+    // Sorts copies of the input into work, doubling the number of runs until they take at least
+    // min_time seconds. Returns the seconds they took, less copying the input, and saves the
+    // number of runs into reps. Leaves the last run's output in work.
+    for (*reps = 1;; *reps *= 2) {
+        double start = get_time();
+        for (int i = 0; i < *reps; i++) {
+            memcpy(work, input, sizeof(int) * n);
+            __asm__ volatile("" : : "r" (work) : "memory"); // Keep the copies from being dropped.
+        }
+        double copy_seconds = get_time() - start;
+
+        start = get_time();
+        for (int i = 0; i < *reps; i++) {
+            memcpy(work, input, sizeof(int) * n);
+            sorter->sort(work, n, NULL);
+        }
+        double seconds = get_time() - start;
+        if (seconds >= min_time || *reps >= (1 << 24)) {
+            return (seconds > copy_seconds) ? seconds - copy_seconds : 0;
+        }
+    }
+}
+
+double get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int find_name(const char* name, const char* names[], int num_names) {
+    for (int i = 0; i < num_names; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int parse_names(char* list, const char* names[], int num_names, int selected[]) {
+    // Selects only the names in a comma-separated list. Returns 0 if one of them is unknown.
+    for (int i = 0; i < num_names; i++) {
+        selected[i] = 0;
+    }
+    for (char* name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        int index = find_name(name, names, num_names);
+        if (index == -1) {
+            printf("Unknown name '%s'. Expected one of:", name);
+            for (int i = 0; i < num_names; i++) {
+                printf(" %s", names[i]);
+            }
+            printf("\n");
+            return 0;
+        }
+        selected[index] = 1;
+    }
+    return 1;
+}
+
+const char* get_kernel_name(void) {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE4_1__)
+    return "SSE4.1";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,83 @@
+// The "z-sort" algorithm (see z-sort.c), for programs that sort with it, such
+// as the sorting benchmark in ../End sort/sortbench.c.
+
+#include <stdio.h>
+
+// Define unix text colors
+#define DARK_RED "\x1B[1;31m"
+#define LIGHT_GREEN "\x1B[1;32m"
+#define NORMAL "\x1B[0m"
+
+void swap(int *p1, int *p2);
+void print_array(int *array, int len, int index);
+int * zsort(int array[], int len, int print_steps, long long* num_swaps);
+
+void swap(int *p1, int *p2) {
+    // Given two pointers, swaps their values.
+    int temp = *p1;
+    *p1 = *p2;
+    *p2 = temp;
+}
+
+void print_array(int array[], int len, int index) {
+    // Given an array, prints out each element in a line spaced out.
+    printf("\n");
+    
+    int i;
+    for (i = 0; i < len; i++) {
+        if (i == index || i == index + 1) {
+            if (array[index] > array[index + 1]) {
+                printf(LIGHT_GREEN "%d ", array[i]);
+            } else {
+                printf(DARK_RED "%d ", array[i]);
+            }
+        } else {
+            printf(NORMAL "%d ", array[i]);
+        }
+    }
+}
+
+int * zsort(int array[], int len, int print_steps, long long* num_swaps) {
+    // Returns a sorted number array using a method called 'z-sort'. Prints
+    // every step if print_steps is set, and saves the number of swaps made
+    // into num_swaps (unless it is NULL). The number of comparisons is always
+    // the number of steps, (len - 1) * len / 2.
+    long long steps = (long long) (len - 1) * ((len - 1) + 1) / 2;
+    long long swaps = 0;
+    long long total_steps = 0;
+    int switches = 0;
+    int direction = 1; // 1 = Forward, -1 = backward
+    long long step = 1;
+    int index = 0;
+
+    while (step <= steps) {
+        int *num1 = &array[index];
+        int *num2 = &array[index + 1];
+
+        if (print_steps) {
+            print_array(array, len, index);
+        }
+        if (*num1 > *num2) {
+            swap(num1, num2);
+            swaps++;
+        }
+
+
+        if (step - total_steps == (len - 1 - switches)) {
+            direction *= (-1);
+            switches++;
+            total_steps = step;
+        } else {
+        }
+        index += direction;
+        step++;
+    }
+    if (print_steps) {
+        printf(" Steps: %lld\n", steps);
+    }
+    if (num_swaps != NULL) {
+        *num_swaps = swaps;
+    }
+
+    return array;
+}